@@ -3,6 +3,7 @@
 #include "Artifice/Core/Core.h"
 #include "Artifice/Core/Application.h"
 #include "Artifice/Core/Input.h"
+#include "Artifice/Core/JobSystem.h"
 #include "Artifice/Core/KeyCodes.h"
 #include "Artifice/Core/MouseCodes.h"
 #include "Artifice/Core/Layer.h"
@@ -13,6 +14,7 @@
 
 #include "Artifice/Graphics/CameraController.h"
 #include "Artifice/Graphics/RenderGraph/RenderGraph.h"
+#include "Artifice/Graphics/RenderGraph/RenderGraphSubgraph.h"
 #include "Artifice/Graphics/Renderer.h"
 #include "Artifice/Graphics/SceneRenderer.h"
 #include "Artifice/Graphics/Renderer2D.h"
@@ -23,5 +25,11 @@
 #include "Artifice/Utils/FileUtils.h"
 
 #include "Artifice/Scene/Entity.h"
+#include "Artifice/Scene/EntityCommandBuffer.h"
+#include "Artifice/Scene/EntitySnapshot.h"
 #include "Artifice/Scene/Scene.h"
-#include "Artifice/Scene/Component.h"
\ No newline at end of file
+#include "Artifice/Scene/Component.h"
+#include "Artifice/Scene/TransformHierarchy.h"
+#include "Artifice/Scene/SystemScheduler.h"
+#include "Artifice/Scene/DynamicBVH.h"
+#include "Artifice/Scene/SpatialIndex.h"
@@ -30,6 +30,9 @@ Application::Application()
 
     m_ScopeAllocator = new ScopeAllocator();
 
+    m_JobSystem = new JobSystem();
+    m_JobSystem->Init();
+
     m_LayerStack = new LayerStack();
     
 
@@ -43,11 +46,12 @@ Application::Application()
     m_RenderBackend = new RenderBackend();
     m_RenderBackend->Init();
 
-    DeviceID device_id = m_RenderBackend->CreateDevice();
+    DeviceID device_id = m_RenderBackend->CreateDevice(m_JobSystem->GetThreadCount());
     device = m_RenderBackend->GetDevice(device_id);
     device->SetVSync(false);
 
     m_RenderGraph = new RenderGraph(device);
+    m_RenderGraph->SetJobSystem(m_JobSystem);
 
     Renderer::Init(device);
 
@@ -84,6 +88,9 @@ Application::~Application()
 
     Window::PlatformCleanUp();
 
+    m_JobSystem->CleanUp();
+    delete m_JobSystem;
+
     delete m_ScopeAllocator;
 }
 
@@ -155,6 +162,9 @@ void Application::Run()
         {
             Timer timer;
 
+            // No jobs are running between frames
+            m_JobSystem->ResetScratch();
+
             for (Layer* layer : *m_LayerStack)
             {
                 layer->OnUpdate(ts);
@@ -190,13 +200,6 @@ void Application::Run()
         }
 
 
-        // stage where do we first need to access swapchain image
-        for (auto vp : viewports)
-        {
-            device->AddWaitForAcquireSwapchainSemaphore(QueueType::Universal, vp, PipelineStageFlags::Color);
-        }
-
-
         m_RenderGraph->Reset();
         m_RenderGraph->AddPass("Clear Primary Swapchain", [&](RenderGraphBuilder* builder) {
             
@@ -234,6 +237,15 @@ void Application::Run()
             };
         });
         m_RenderGraph->Compile();
+        // Subgraphs submit on their own, the acquire semaphore has to be waited on by the first submit of the graph
+        m_RenderGraph->EvaluateSubgraphs();
+
+        // stage where do we first need to access swapchain image
+        for (auto vp : viewports)
+        {
+            device->AddWaitForAcquireSwapchainSemaphore(QueueType::Universal, vp, PipelineStageFlags::Color);
+        }
+
         m_RenderGraph->Evaluate(); // Automatically submits to queues
 
 
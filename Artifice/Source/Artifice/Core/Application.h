@@ -1,6 +1,7 @@
 #pragma once
 
 #include "Artifice/Core/Core.h"
+#include "Artifice/Core/JobSystem.h"
 #include "Artifice/Core/ScratchAllocator.h"
 #include "Artifice/Core/Layer.h"
 #include "Artifice/Core/LayerStack.h"
@@ -34,6 +35,7 @@ private:
     RenderGraph* m_RenderGraph;
 
     ScopeAllocator* m_ScopeAllocator;
+    JobSystem* m_JobSystem;
     
     RenderBackend* m_RenderBackend;
     Device* device;
@@ -61,6 +63,7 @@ public:
     bool OnWindowResize(WindowResizeEvent& e);
 
     RenderGraph* GetRenderGraph() { return m_RenderGraph; }
+    JobSystem* GetJobSystem() { return m_JobSystem; }
     RenderBackend* GetRenderBackend() { return m_RenderBackend; }
     Window* GetWindow() { return m_Window; }
     RenderHandle GetSwapchain() { return m_Swapchain; }
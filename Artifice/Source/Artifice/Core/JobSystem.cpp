@@ -0,0 +1,148 @@
+#include "JobSystem.h"
+
+#include "Artifice/Core/Log.h"
+
+
+static thread_local uint32 s_ThreadIndex = 0;
+
+void JobSystem::Init(uint32 worker_count)
+{
+    AR_CORE_ASSERT(!m_Running, "Tried initializing job system that is already running");
+
+    if (worker_count == 0)
+    {
+        uint32 hardware_threads = std::thread::hardware_concurrency();
+        worker_count = hardware_threads > 1 ? hardware_threads - 1 : 1;
+    }
+
+    m_Running = true;
+    s_ThreadIndex = 0;
+
+    for (uint32 i = 0; i < worker_count + 1; i++)
+    {
+        m_ThreadScratch.push_back(new ScratchAllocator(1024 * 64));
+    }
+    for (uint32 i = 0; i < worker_count; i++)
+    {
+        m_Workers.emplace_back([this, i]() { WorkerLoop(i + 1); });
+    }
+}
+
+void JobSystem::CleanUp()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_JobsMutex);
+        m_Running = false;
+    }
+    m_JobsCondition.notify_all();
+
+    for (std::thread& worker : m_Workers)
+    {
+        worker.join();
+    }
+    m_Workers.clear();
+
+    for (ScratchAllocator* scratch : m_ThreadScratch)
+    {
+        delete scratch;
+    }
+    m_ThreadScratch.clear();
+}
+
+void JobSystem::Execute(JobFunction job, JobCounter* counter)
+{
+    counter->Count.fetch_add(1, std::memory_order_relaxed);
+    {
+        std::lock_guard<std::mutex> lock(m_JobsMutex);
+        m_Jobs.push_back({std::move(job), counter});
+    }
+    m_JobsCondition.notify_one();
+}
+
+void JobSystem::Wait(JobCounter* counter)
+{
+    while (!counter->IsDone())
+    {
+        if (!TryExecuteJob())
+        {
+            std::this_thread::yield();
+        }
+    }
+}
+
+void JobSystem::Dispatch(uint32 job_count, const DispatchFunction& func)
+{
+    if (job_count == 0)
+    {
+        return;
+    }
+
+    JobCounter counter;
+    for (uint32 i = 1; i < job_count; i++)
+    {
+        Execute([&func, i]() { func(i); }, &counter);
+    }
+
+    // Calling thread takes the first job itself
+    func(0);
+
+    Wait(&counter);
+}
+
+void JobSystem::ResetScratch()
+{
+    for (ScratchAllocator* scratch : m_ThreadScratch)
+    {
+        scratch->Reset();
+    }
+}
+
+uint32 JobSystem::GetThreadIndex()
+{
+    return s_ThreadIndex;
+}
+
+void JobSystem::WorkerLoop(uint32 thread_index)
+{
+    s_ThreadIndex = thread_index;
+
+    while (true)
+    {
+        Job job;
+        {
+            std::unique_lock<std::mutex> lock(m_JobsMutex);
+            m_JobsCondition.wait(lock, [this]() { return !m_Running || !m_Jobs.empty(); });
+
+            if (!m_Running && m_Jobs.empty())
+            {
+                return;
+            }
+
+            job = std::move(m_Jobs.front());
+            m_Jobs.pop_front();
+        }
+
+        job.Function();
+        job.Counter->Count.fetch_sub(1, std::memory_order_release);
+    }
+}
+
+bool JobSystem::TryExecuteJob()
+{
+    Job job;
+    {
+        std::lock_guard<std::mutex> lock(m_JobsMutex);
+        if (m_Jobs.empty())
+        {
+            return false;
+        }
+
+        job = std::move(m_Jobs.front());
+        m_Jobs.pop_front();
+    }
+
+    job.Function();
+    job.Counter->Count.fetch_sub(1, std::memory_order_release);
+
+    return true;
+}
@@ -0,0 +1,72 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "Artifice/Core/Core.h"
+#include "Artifice/Core/ScratchAllocator.h"
+
+
+// Counts outstanding jobs of a batch, the batch is done when it reaches zero
+struct JobCounter
+{
+    std::atomic<uint32> Count = {0};
+
+    bool IsDone() const { return Count.load(std::memory_order_acquire) == 0; }
+};
+
+class JobSystem
+{
+public:
+    using JobFunction = std::function<void()>;
+    using DispatchFunction = std::function<void(uint32 job_index)>;
+
+private:
+    struct Job
+    {
+        JobFunction Function;
+        JobCounter* Counter;
+    };
+
+    std::vector<std::thread> m_Workers;
+    // Thread index 0 is the thread that called Init, workers are 1..N
+    std::vector<ScratchAllocator*> m_ThreadScratch;
+
+    std::deque<Job> m_Jobs;
+    std::mutex m_JobsMutex;
+    std::condition_variable m_JobsCondition;
+    bool m_Running = false;
+
+public:
+    JobSystem() = default;
+
+    // worker_count of 0 uses one worker per hardware thread, minus the calling thread
+    void Init(uint32 worker_count = 0);
+    void CleanUp();
+
+    void Execute(JobFunction job, JobCounter* counter);
+    // Blocks until the counter reaches zero, the calling thread executes jobs while waiting
+    void Wait(JobCounter* counter);
+
+    // Runs func(job_index) for job_index in [0, job_count) and joins.
+    void Dispatch(uint32 job_count, const DispatchFunction& func);
+    // Frees the per-thread scratch memory, once per frame while no jobs are running, so scratch memory is only valid
+    // until the end of the frame.
+    void ResetScratch();
+
+    // Worker threads plus the calling thread
+    uint32 GetThreadCount() const { return m_Workers.size() + 1; }
+    ScratchAllocator* GetThreadScratch() { return m_ThreadScratch[GetThreadIndex()]; }
+
+    // Index of the current thread, in [0, GetThreadCount())
+    static uint32 GetThreadIndex();
+
+private:
+    void WorkerLoop(uint32 thread_index);
+    bool TryExecuteJob();
+};
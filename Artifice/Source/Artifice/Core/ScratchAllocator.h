@@ -1,6 +1,7 @@
 #pragma once
 
 #include <vector>
+#include <mutex>
 
 #include "Artifice/Core/Core.h"
 #include "Artifice/Core/DataBuffer.h"
@@ -162,6 +163,8 @@ public:
 class ScopeAllocator
 {
     std::vector<ScratchAllocator*> m_ScratchAllocators;
+    // Scopes are requested from every thread recording render graph passes
+    std::mutex m_Mutex;
 
 public:
     ScopeAllocator() = default;
@@ -175,6 +178,7 @@ public:
 
     ScratchAllocator* RequestScope()
     {
+        std::lock_guard<std::mutex> lock(m_Mutex);
         if (m_ScratchAllocators.size())
         {
             ScratchAllocator* ret = m_ScratchAllocators.back();
@@ -187,6 +191,7 @@ public:
     void ReturnScope(ScratchAllocator* allocator)
     {
         allocator->Reset();
+        std::lock_guard<std::mutex> lock(m_Mutex);
         m_ScratchAllocators.push_back(allocator);
     }
 };
\ No newline at end of file
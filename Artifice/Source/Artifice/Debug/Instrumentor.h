@@ -5,6 +5,7 @@
 #include <algorithm>
 #include <fstream>
 #include <thread>
+#include <mutex>
 
 #include "Artifice/Core/Core.h"
 
@@ -27,6 +28,7 @@ private:
     InstrumentationSession* m_CurrentSession;
     std::ofstream m_OutputStream;
     int m_ProfileCount;
+    std::mutex m_Mutex;
 public:
     Instrumentor()
         : m_CurrentSession(nullptr), m_ProfileCount(0)
@@ -51,6 +53,7 @@ public:
 
     void WriteProfile(const ProfileResult& result)
     {
+        std::lock_guard<std::mutex> lock(m_Mutex);
         if (m_ProfileCount++ > 0)
             m_OutputStream << ",";
 
@@ -260,6 +260,65 @@ void CommandBuffer::TextureBarrier(RenderHandle texture, ResourceState source, R
 {
     AR_PROFILE_FUNCTION();
 
+    BarrierBatch batch;
+    AddTextureBarrier(&batch, texture, source, destination, source_queue_family, destination_queue_family);
+    PipelineBarrier(batch);
+}
+void CommandBuffer::AliasingBarrier(RenderHandle texture, ResourceState previous, ResourceState destination)
+{
+    AR_PROFILE_FUNCTION();
+
+    BarrierBatch batch;
+    AddAliasingBarrier(&batch, texture, previous, destination);
+    PipelineBarrier(batch);
+}
+void CommandBuffer::BufferBarrier(RenderHandle buffer, ResourceState source, ResourceState destination, uint32 source_queue_family, uint32 destination_queue_family)
+{
+    AR_PROFILE_FUNCTION();
+
+    BarrierBatch batch;
+    AddBufferBarrier(&batch, buffer, source, destination, source_queue_family, destination_queue_family);
+    PipelineBarrier(batch);
+}
+
+void CommandBuffer::ReleaseTextureQueueOwnership(QueueType source_queue, QueueType destination_queue, RenderHandle texture, ResourceState source, ResourceState destination)
+{
+    AR_PROFILE_FUNCTION();
+
+    BarrierBatch batch;
+    AddReleaseTextureQueueOwnership(&batch, source_queue, destination_queue, texture, source, destination);
+    PipelineBarrier(batch);
+}
+
+void CommandBuffer::AcquireTextureQueueOwnership(QueueType source_queue, QueueType destination_queue, RenderHandle texture, ResourceState source, ResourceState destination)
+{
+    AR_PROFILE_FUNCTION();
+
+    BarrierBatch batch;
+    AddAcquireTextureQueueOwnership(&batch, source_queue, destination_queue, texture, source, destination);
+    PipelineBarrier(batch);
+}
+
+void CommandBuffer::ReleaseBufferQueueOwnership(QueueType source_queue, QueueType destination_queue, RenderHandle buffer, ResourceState source)
+{
+    AR_PROFILE_FUNCTION();
+
+    BarrierBatch batch;
+    AddReleaseBufferQueueOwnership(&batch, source_queue, destination_queue, buffer, source);
+    PipelineBarrier(batch);
+}
+
+void CommandBuffer::AcquireBufferQueueOwnership(QueueType source_queue, QueueType destination_queue, RenderHandle buffer, ResourceState destination)
+{
+    AR_PROFILE_FUNCTION();
+
+    BarrierBatch batch;
+    AddAcquireBufferQueueOwnership(&batch, source_queue, destination_queue, buffer, destination);
+    PipelineBarrier(batch);
+}
+
+void CommandBuffer::AddTextureBarrier(BarrierBatch* batch, RenderHandle texture, ResourceState source, ResourceState destination, uint32 source_queue_family, uint32 destination_queue_family)
+{
     Texture* tex = m_Device->GetTexture(texture);
 
     VulkanResourceState source_raw = RenderBackend::ConvertResourceState(source);
@@ -279,24 +338,40 @@ void CommandBuffer::TextureBarrier(RenderHandle texture, ResourceState source, R
     barrier.subresourceRange.levelCount = tex->Mips;
     barrier.subresourceRange.baseArrayLayer = 0;
     barrier.subresourceRange.layerCount = tex->Info.Layers;
+    batch->ImageBarriers.push_back(barrier);
 
-    VkPipelineStageFlags source_stage = source_raw.Stage;
-    VkPipelineStageFlags destination_stage = destination_raw.Stage;
-    if (source_stage == 0)
-    {
-        source_stage = VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT;
-    }
-    if (destination_stage == 0)
-    {
-        destination_stage = VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT;
-    }
-
-    vkCmdPipelineBarrier(m_CommandBuffer, source_stage, destination_stage, 0, 0, nullptr, 0, nullptr, 1, &barrier);
+    batch->SourceStage |= source_raw.Stage ? source_raw.Stage : VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT;
+    batch->DestinationStage |= destination_raw.Stage ? destination_raw.Stage : VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT;
 }
-void CommandBuffer::BufferBarrier(RenderHandle buffer, ResourceState source, ResourceState destination, uint32 source_queue_family, uint32 destination_queue_family)
+void CommandBuffer::AddAliasingBarrier(BarrierBatch* batch, RenderHandle texture, ResourceState previous, ResourceState destination)
 {
-    AR_PROFILE_FUNCTION();
+    Texture* tex = m_Device->GetTexture(texture);
+
+    VulkanResourceState previous_raw = RenderBackend::ConvertResourceState(previous);
+    VulkanResourceState destination_raw = RenderBackend::ConvertResourceState(destination);
+
+    // Waits for and flushes the previous users of the memory, the old layout is undefined since nothing is kept
+    VkImageMemoryBarrier barrier = {};
+    barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+    barrier.srcAccessMask = previous_raw.Access;
+    barrier.dstAccessMask = destination_raw.Access;
+    barrier.oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+    barrier.newLayout = destination_raw.ImageLayout;
+    barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barrier.image = tex->Image;
+    barrier.subresourceRange.aspectMask = Device::GetAspectFlagsFromFormat(tex->Info.Format);
+    barrier.subresourceRange.baseMipLevel = 0;
+    barrier.subresourceRange.levelCount = tex->Mips;
+    barrier.subresourceRange.baseArrayLayer = 0;
+    barrier.subresourceRange.layerCount = tex->Info.Layers;
+    batch->ImageBarriers.push_back(barrier);
 
+    batch->SourceStage |= previous_raw.Stage ? previous_raw.Stage : VK_PIPELINE_STAGE_ALL_COMMANDS_BIT;
+    batch->DestinationStage |= destination_raw.Stage ? destination_raw.Stage : VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT;
+}
+void CommandBuffer::AddBufferBarrier(BarrierBatch* batch, RenderHandle buffer, ResourceState source, ResourceState destination, uint32 source_queue_family, uint32 destination_queue_family)
+{
     Buffer* buf = m_Device->GetBuffer(buffer);
 
     VulkanResourceState source_raw = RenderBackend::ConvertResourceState(source);
@@ -311,30 +386,16 @@ void CommandBuffer::BufferBarrier(RenderHandle buffer, ResourceState source, Res
     barrier.buffer = buf->BufferRaw;
     barrier.offset = 0;
     barrier.size = buf->Info.Size;
+    batch->BufferBarriers.push_back(barrier);
 
-    VkPipelineStageFlags source_stage = source_raw.Stage;
-    VkPipelineStageFlags destination_stage = destination_raw.Stage;
-    if (source_stage == 0)
-    {
-        source_stage = VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT;
-    }
-    if (destination_stage == 0)
-    {
-        destination_stage = VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT;
-    }
-
-    vkCmdPipelineBarrier(m_CommandBuffer, source_stage, destination_stage, 0, 0, nullptr, 1, &barrier, 0, nullptr);
+    batch->SourceStage |= source_raw.Stage ? source_raw.Stage : VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT;
+    batch->DestinationStage |= destination_raw.Stage ? destination_raw.Stage : VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT;
 }
 
-void CommandBuffer::ReleaseTextureQueueOwnership(QueueType source_queue, QueueType destination_queue, RenderHandle texture, ResourceState source, ResourceState destination)
+void CommandBuffer::AddReleaseTextureQueueOwnership(BarrierBatch* batch, QueueType source_queue, QueueType destination_queue, RenderHandle texture, ResourceState source, ResourceState destination)
 {
-    AR_PROFILE_FUNCTION();
-
-    int32 source_family = m_Device->GetQueueFamilyIndex(source_queue);
-    int32 destination_family = m_Device->GetQueueFamilyIndex(destination_queue);
-
-    AR_CORE_ASSERT(source_family != -1, "Unsupported queue type");
-    AR_CORE_ASSERT(destination_family != -1, "Unsupported queue type");
+    int32 source_family = GetQueueFamily(source_queue);
+    int32 destination_family = GetQueueFamily(destination_queue);
 
     Texture* tex = m_Device->GetTexture(texture);
 
@@ -355,25 +416,16 @@ void CommandBuffer::ReleaseTextureQueueOwnership(QueueType source_queue, QueueTy
     barrier.subresourceRange.levelCount = tex->Mips;
     barrier.subresourceRange.baseArrayLayer = 0;
     barrier.subresourceRange.layerCount = tex->Info.Layers;
+    batch->ImageBarriers.push_back(barrier);
 
-    VkPipelineStageFlags source_stage = source_raw.Stage;
-    if (source_stage == 0)
-    {
-        source_stage = VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT;
-    }
-
-    vkCmdPipelineBarrier(m_CommandBuffer, source_stage, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, 0, 0, nullptr, 0, nullptr, 1, &barrier);
+    batch->SourceStage |= source_raw.Stage ? source_raw.Stage : VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT;
+    batch->DestinationStage |= VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT;
 }
 
-void CommandBuffer::AcquireTextureQueueOwnership(QueueType source_queue, QueueType destination_queue, RenderHandle texture, ResourceState source, ResourceState destination)
+void CommandBuffer::AddAcquireTextureQueueOwnership(BarrierBatch* batch, QueueType source_queue, QueueType destination_queue, RenderHandle texture, ResourceState source, ResourceState destination)
 {
-    AR_PROFILE_FUNCTION();
-
-    int32 source_family = m_Device->GetQueueFamilyIndex(source_queue);
-    int32 destination_family = m_Device->GetQueueFamilyIndex(destination_queue);
-
-    AR_CORE_ASSERT(source_family != -1, "Unsupported queue type");
-    AR_CORE_ASSERT(destination_family != -1, "Unsupported queue type");
+    int32 source_family = GetQueueFamily(source_queue);
+    int32 destination_family = GetQueueFamily(destination_queue);
 
     Texture* tex = m_Device->GetTexture(texture);
 
@@ -394,38 +446,60 @@ void CommandBuffer::AcquireTextureQueueOwnership(QueueType source_queue, QueueTy
     barrier.subresourceRange.levelCount = tex->Mips;
     barrier.subresourceRange.baseArrayLayer = 0;
     barrier.subresourceRange.layerCount = tex->Info.Layers;
+    batch->ImageBarriers.push_back(barrier);
 
-    VkPipelineStageFlags destination_stage = destination_raw.Stage;
-    if (destination_stage == 0)
-    {
-        destination_stage = VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT;
-    }
+    batch->SourceStage |= VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT;
+    batch->DestinationStage |= destination_raw.Stage ? destination_raw.Stage : VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT;
+}
 
-    vkCmdPipelineBarrier(m_CommandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, destination_stage, 0, 0, nullptr, 0, nullptr, 1, &barrier);
+void CommandBuffer::AddReleaseBufferQueueOwnership(BarrierBatch* batch, QueueType source_queue, QueueType destination_queue, RenderHandle buffer, ResourceState source)
+{
+    int32 source_family = GetQueueFamily(source_queue);
+    int32 destination_family = GetQueueFamily(destination_queue);
+
+    AddBufferBarrier(batch, buffer, source, {RenderBindFlags::None, PipelineStageFlags::None}, source_family, destination_family);
 }
 
-void CommandBuffer::ReleaseBufferQueueOwnership(QueueType source_queue, QueueType destination_queue, RenderHandle buffer, ResourceState source)
+void CommandBuffer::AddAcquireBufferQueueOwnership(BarrierBatch* batch, QueueType source_queue, QueueType destination_queue, RenderHandle buffer, ResourceState destination)
 {
-    AR_PROFILE_FUNCTION();
+    int32 source_family = GetQueueFamily(source_queue);
+    int32 destination_family = GetQueueFamily(destination_queue);
 
-    int32 source_family = m_Device->GetQueueFamilyIndex(source_queue);
-    int32 destination_family = m_Device->GetQueueFamilyIndex(destination_queue);
+    AddBufferBarrier(batch, buffer, {RenderBindFlags::None, PipelineStageFlags::None}, destination, source_family, destination_family);
+}
 
-    AR_CORE_ASSERT(source_family != -1, "Unsupported queue type");
-    AR_CORE_ASSERT(destination_family != -1, "Unsupported queue type");
+void CommandBuffer::PipelineBarrier(const BarrierBatch& batch)
+{
+    if (batch.IsEmpty())
+    {
+        return;
+    }
 
-    BufferBarrier(buffer, source, {RenderBindFlags::None, PipelineStageFlags::None}, source_family, destination_family);
+    vkCmdPipelineBarrier(m_CommandBuffer, batch.SourceStage, batch.DestinationStage, 0, 0, nullptr,
+                         batch.BufferBarriers.size(), batch.BufferBarriers.data(), batch.ImageBarriers.size(), batch.ImageBarriers.data());
 }
 
-void CommandBuffer::AcquireBufferQueueOwnership(QueueType source_queue, QueueType destination_queue, RenderHandle buffer, ResourceState destination)
+void CommandBuffer::SetEvent(VkEvent event, const BarrierBatch& batch)
 {
-    AR_PROFILE_FUNCTION();
+    // Signaled once the source stages of the earlier commands are done
+    vkCmdSetEvent(m_CommandBuffer, event, batch.SourceStage);
+}
 
-    int32 source_family = m_Device->GetQueueFamilyIndex(source_queue);
-    int32 destination_family = m_Device->GetQueueFamilyIndex(destination_queue);
+void CommandBuffer::WaitEvents(const std::vector<VkEvent>& events, const BarrierBatch& batch)
+{
+    if (events.empty())
+    {
+        return;
+    }
 
-    AR_CORE_ASSERT(source_family != -1, "Unsupported queue type");
-    AR_CORE_ASSERT(destination_family != -1, "Unsupported queue type");
+    // The source stages are those of every SetEvent
+    vkCmdWaitEvents(m_CommandBuffer, events.size(), events.data(), batch.SourceStage, batch.DestinationStage, 0, nullptr,
+                    batch.BufferBarriers.size(), batch.BufferBarriers.data(), batch.ImageBarriers.size(), batch.ImageBarriers.data());
+}
 
-    BufferBarrier(buffer, {RenderBindFlags::None, PipelineStageFlags::None}, destination, source_family, destination_family);
+int32 CommandBuffer::GetQueueFamily(QueueType queue)
+{
+    int32 family = m_Device->GetQueueFamilyIndex(queue);
+    AR_CORE_ASSERT(family != -1, "Unsupported queue type");
+    return family;
 }
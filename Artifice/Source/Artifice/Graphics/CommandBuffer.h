@@ -1,11 +1,24 @@
 #pragma once
 
+#include <vector>
+
 #include <vulkan/vulkan.h>
 
 #include "Resources.h"
 
 class Device;
 
+// Barriers issued together by one vkCmdPipelineBarrier, or split between CommandBuffer::SetEvent and WaitEvents
+struct BarrierBatch
+{
+    VkPipelineStageFlags SourceStage = 0;
+    VkPipelineStageFlags DestinationStage = 0;
+    std::vector<VkImageMemoryBarrier> ImageBarriers;
+    std::vector<VkBufferMemoryBarrier> BufferBarriers;
+
+    bool IsEmpty() const { return ImageBarriers.empty() && BufferBarriers.empty(); }
+};
+
 
 class CommandBuffer
 {
@@ -66,10 +79,31 @@ public: // Synchronization commands
     // Barriers
     void TextureBarrier(RenderHandle texture, ResourceState source, ResourceState destination, uint32 source_queue_family = VK_QUEUE_FAMILY_IGNORED, uint32 destination_queue_family = VK_QUEUE_FAMILY_IGNORED);
     void BufferBarrier(RenderHandle buffer, ResourceState source, ResourceState destination, uint32 source_queue_family = VK_QUEUE_FAMILY_IGNORED, uint32 destination_queue_family = VK_QUEUE_FAMILY_IGNORED);
+    // Texture taking over memory last used by other resources in the previous state, its contents are discarded
+    void AliasingBarrier(RenderHandle texture, ResourceState previous, ResourceState destination);
 
     // Synchronize resource ownerships between queue families
     void ReleaseTextureQueueOwnership(QueueType source_queue, QueueType destination_queue, RenderHandle texture, ResourceState source, ResourceState destination);
     void AcquireTextureQueueOwnership(QueueType source_queue, QueueType destination_queue, RenderHandle texture, ResourceState source, ResourceState destination);
     void ReleaseBufferQueueOwnership(QueueType source_queue, QueueType destination_queue, RenderHandle buffer, ResourceState source);
     void AcquireBufferQueueOwnership(QueueType source_queue, QueueType destination_queue, RenderHandle buffer, ResourceState destination);
+
+    // Same as above, but only added to the batch
+    void AddTextureBarrier(BarrierBatch* batch, RenderHandle texture, ResourceState source, ResourceState destination, uint32 source_queue_family = VK_QUEUE_FAMILY_IGNORED, uint32 destination_queue_family = VK_QUEUE_FAMILY_IGNORED);
+    void AddBufferBarrier(BarrierBatch* batch, RenderHandle buffer, ResourceState source, ResourceState destination, uint32 source_queue_family = VK_QUEUE_FAMILY_IGNORED, uint32 destination_queue_family = VK_QUEUE_FAMILY_IGNORED);
+    void AddAliasingBarrier(BarrierBatch* batch, RenderHandle texture, ResourceState previous, ResourceState destination);
+    void AddReleaseTextureQueueOwnership(BarrierBatch* batch, QueueType source_queue, QueueType destination_queue, RenderHandle texture, ResourceState source, ResourceState destination);
+    void AddAcquireTextureQueueOwnership(BarrierBatch* batch, QueueType source_queue, QueueType destination_queue, RenderHandle texture, ResourceState source, ResourceState destination);
+    void AddReleaseBufferQueueOwnership(BarrierBatch* batch, QueueType source_queue, QueueType destination_queue, RenderHandle buffer, ResourceState source);
+    void AddAcquireBufferQueueOwnership(BarrierBatch* batch, QueueType source_queue, QueueType destination_queue, RenderHandle buffer, ResourceState destination);
+
+    // Issues every barrier of the batch at once, nothing if it's empty
+    void PipelineBarrier(const BarrierBatch& batch);
+    // Split barrier, work after SetEvent runs until the barriers are needed at WaitEvents. The wait takes the batches
+    // of all its events combined.
+    void SetEvent(VkEvent event, const BarrierBatch& batch);
+    void WaitEvents(const std::vector<VkEvent>& events, const BarrierBatch& batch);
+
+private:
+    int32 GetQueueFamily(QueueType queue);
 };
\ No newline at end of file
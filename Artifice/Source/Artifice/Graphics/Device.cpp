@@ -18,7 +18,7 @@ Device::~Device()
 {
 }
 
-void Device::Init(VkInstance instance, RenderHandleAllocator<AR_HANDLE_RING_SIZE>* allocator)
+void Device::Init(VkInstance instance, RenderHandleAllocator<AR_HANDLE_RING_SIZE>* allocator, uint32 thread_count)
 {
     AR_PROFILE_FUNCTION();
 
@@ -69,7 +69,13 @@ void Device::Init(VkInstance instance, RenderHandleAllocator<AR_HANDLE_RING_SIZE
     }
 
     m_DescriptorSetLayoutInternalCache.Init(m_Handle);
-    m_DescriptorSetCache.Init(this);
+    m_SemaphoreAllocator.Init(m_Handle);
+    m_ThreadCount = thread_count;
+    m_DescriptorSetCaches.resize(m_ThreadCount);
+    for (auto& cache : m_DescriptorSetCaches)
+    {
+        cache.Init(this);
+    }
 
     for (uint32 i = 0; i < AR_FRAME_COUNT; i++)
     {
@@ -78,14 +84,20 @@ void Device::Init(VkInstance instance, RenderHandleAllocator<AR_HANDLE_RING_SIZE
         frame.Device = m_Handle;
         // TODO: should store actual device
         frame.DescriptorSetLayoutInternalCache = &m_DescriptorSetLayoutInternalCache;
+        frame.SemaphoreAllocator = &m_SemaphoreAllocator;
         frame.GeneralFencePool.Init(m_Handle);
-        frame.UniversalCommandPool.Init(m_Handle, m_UniversalFamilyIndex);
-        frame.ComputeCommandPool.Init(m_Handle, m_ComputeFamilyIndex);
 
-        frame.ScratchVertexAllocator = ScratchBufferAllocator(this, 1024 * 4, RenderBindFlags::VertexBuffer);
-        frame.ScratchIndexAllocator = ScratchBufferAllocator(this, 1024 * 4, RenderBindFlags::IndexBuffer);
-        frame.ScratchUniformAllocator = ScratchBufferAllocator(this, 1024 * 4, RenderBindFlags::UniformBuffer);
-        frame.ScratchStorageAllocator = ScratchBufferAllocator(this, 1024 * 4, RenderBindFlags::StorageBuffer);
+        frame.Threads.resize(m_ThreadCount);
+        for (auto& thread : frame.Threads)
+        {
+            thread.UniversalCommandPool.Init(m_Handle, m_UniversalFamilyIndex);
+            thread.ComputeCommandPool.Init(m_Handle, m_ComputeFamilyIndex);
+
+            thread.ScratchVertexAllocator = ScratchBufferAllocator(this, 1024 * 4, RenderBindFlags::VertexBuffer);
+            thread.ScratchIndexAllocator = ScratchBufferAllocator(this, 1024 * 4, RenderBindFlags::IndexBuffer);
+            thread.ScratchUniformAllocator = ScratchBufferAllocator(this, 1024 * 4, RenderBindFlags::UniformBuffer);
+            thread.ScratchStorageAllocator = ScratchBufferAllocator(this, 1024 * 4, RenderBindFlags::StorageBuffer);
+        }
     }
 
 }
@@ -100,10 +112,13 @@ void Device::CleanUp()
     {
         Frame& frame = m_Frames[i];
 
-        frame.ScratchVertexAllocator.CleanUp();
-        frame.ScratchIndexAllocator.CleanUp();
-        frame.ScratchUniformAllocator.CleanUp();
-        frame.ScratchStorageAllocator.CleanUp();
+        for (auto& thread : frame.Threads)
+        {
+            thread.ScratchVertexAllocator.CleanUp();
+            thread.ScratchIndexAllocator.CleanUp();
+            thread.ScratchUniformAllocator.CleanUp();
+            thread.ScratchStorageAllocator.CleanUp();
+        }
     }
     for (uint32 i = 0; i < AR_FRAME_COUNT; i++)
     {
@@ -111,14 +126,21 @@ void Device::CleanUp()
 
         frame.Begin();
 
-        frame.UniversalCommandPool.CleanUp();
-        frame.ComputeCommandPool.CleanUp();
+        for (auto& thread : frame.Threads)
+        {
+            thread.UniversalCommandPool.CleanUp();
+            thread.ComputeCommandPool.CleanUp();
+        }
         frame.GeneralFencePool.CleanUp();
         frame.TransferFencePool.CleanUp();
     }
 
-    m_DescriptorSetCache.Reset();
+    for (auto& cache : m_DescriptorSetCaches)
+    {
+        cache.Reset();
+    }
     m_DescriptorSetLayoutInternalCache.Reset();
+    m_SemaphoreAllocator.CleanUp();
 
     vkDestroyDevice(m_Handle, nullptr);
 }
@@ -663,83 +685,146 @@ void Device::DestroyBuffer(RenderHandle buffer_handle)
 // Textures
 
 RenderHandle Device::CreateTexture(const TextureInfo& info)
+{
+    return CreateTextureInternal(info, nullptr, 0);
+}
+
+RenderHandle Device::CreatePlacedTexture(const TextureInfo& info, const MemoryHeap& heap, uint64 offset)
+{
+    return CreateTextureInternal(info, &heap, offset);
+}
+
+MemoryRequirements Device::GetTextureMemoryRequirements(const TextureInfo& info)
 {
     AR_PROFILE_FUNCTION();
 
     VkImageType image_type;
     VkImageViewType view_type;
-    VkFlags flags = 0;
+    VkFlags flags;
+    VkImageUsageFlags usage_flags;
+    uint32 mips;
+    GetImageParameters(info, &image_type, &view_type, &flags, &usage_flags, &mips);
+
+    // Only queried, never bound
+    VkImage image;
+    CreateRawUnboundImage(&image, image_type, info.Width, info.Height, info.Depth, mips, info.Layers, info.Format, usage_flags, info.Samples, flags);
+
+    VkMemoryRequirements memory_requirements;
+    vkGetImageMemoryRequirements(m_Handle, image, &memory_requirements);
+    vkDestroyImage(m_Handle, image, nullptr);
+
+    return {memory_requirements.size, memory_requirements.alignment, memory_requirements.memoryTypeBits};
+}
+
+MemoryHeap Device::AllocateMemoryHeap(uint64 size, uint32 memory_type_bits)
+{
+    AR_PROFILE_FUNCTION();
+
+    VkMemoryAllocateInfo ai = {};
+    ai.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+    ai.allocationSize = size;
+    ai.memoryTypeIndex = FindMemoryType(memory_type_bits, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+
+    MemoryHeap heap;
+    VK_CALL(vkAllocateMemory(m_Handle, &ai, nullptr, &heap.Memory));
+    heap.Size = size;
+    heap.MemoryTypeBits = memory_type_bits;
+
+    return heap;
+}
+
+void Device::FreeMemoryHeap(const MemoryHeap& heap)
+{
+    // Textures placed in the heap may still be in use by frames in flight
+    GetFrame()->MemoryToFree.push_back(heap.Memory);
+}
+
+void Device::GetImageParameters(const TextureInfo& info, VkImageType* image_type, VkImageViewType* view_type, VkFlags* flags, VkImageUsageFlags* usage, uint32* mips)
+{
+    *flags = 0;
     switch (info.Type)
     {
     case TextureType::Texture1D:
-        image_type = VK_IMAGE_TYPE_1D;
-        view_type = VK_IMAGE_VIEW_TYPE_1D;
+        *image_type = VK_IMAGE_TYPE_1D;
+        *view_type = VK_IMAGE_VIEW_TYPE_1D;
         break;
     case TextureType::Texture1DArray:
-        image_type = VK_IMAGE_TYPE_1D;
-        view_type = VK_IMAGE_VIEW_TYPE_1D_ARRAY;
+        *image_type = VK_IMAGE_TYPE_1D;
+        *view_type = VK_IMAGE_VIEW_TYPE_1D_ARRAY;
         break;
     case TextureType::Texture2D:
-        image_type = VK_IMAGE_TYPE_2D;
-        view_type = VK_IMAGE_VIEW_TYPE_2D;
+        *image_type = VK_IMAGE_TYPE_2D;
+        *view_type = VK_IMAGE_VIEW_TYPE_2D;
         break;
     case TextureType::Texture2DArray:
-        image_type = VK_IMAGE_TYPE_2D;
-        view_type = VK_IMAGE_VIEW_TYPE_2D_ARRAY;
+        *image_type = VK_IMAGE_TYPE_2D;
+        *view_type = VK_IMAGE_VIEW_TYPE_2D_ARRAY;
         break;
     case TextureType::TextureCube:
-        image_type = VK_IMAGE_TYPE_2D;
-        view_type = VK_IMAGE_VIEW_TYPE_CUBE;
-        flags = VK_IMAGE_CREATE_CUBE_COMPATIBLE_BIT;
+        *image_type = VK_IMAGE_TYPE_2D;
+        *view_type = VK_IMAGE_VIEW_TYPE_CUBE;
+        *flags = VK_IMAGE_CREATE_CUBE_COMPATIBLE_BIT;
         break;
     case TextureType::Texture3D:
-        image_type = VK_IMAGE_TYPE_3D;
-        view_type = VK_IMAGE_VIEW_TYPE_3D;
+        *image_type = VK_IMAGE_TYPE_3D;
+        *view_type = VK_IMAGE_VIEW_TYPE_3D;
         break;
     default:
         break;
     }
 
-    VkImageUsageFlags usage_flags = 0;
+    *usage = 0;
     if (Contains(info.BindFlags, RenderBindFlags::TransferSource) || Contains(info.BindFlags, RenderBindFlags::TransferDestination))
     {
-        usage_flags |= VK_IMAGE_USAGE_TRANSFER_SRC_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT;
+        *usage |= VK_IMAGE_USAGE_TRANSFER_SRC_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT;
     }
     if (Contains(info.BindFlags, RenderBindFlags::TransferDestination))
     {
-        usage_flags |= VK_IMAGE_USAGE_TRANSFER_DST_BIT;
+        *usage |= VK_IMAGE_USAGE_TRANSFER_DST_BIT;
     }
     if (Contains(info.BindFlags, RenderBindFlags::ColorAttachment))
     {
-        usage_flags |= VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT;
+        *usage |= VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT;
     }
     if (Contains(info.BindFlags, RenderBindFlags::ResolveAttachment))
     {
-        usage_flags |= VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT;
+        *usage |= VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT;
     }
     if (Contains(info.BindFlags, RenderBindFlags::DepthStencilAttachment))
     {
-        usage_flags |= VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT;
+        *usage |= VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT;
     }
     if (Contains(info.BindFlags, RenderBindFlags::SampledTexture))
     {
-        usage_flags |= VK_IMAGE_USAGE_SAMPLED_BIT;
+        *usage |= VK_IMAGE_USAGE_SAMPLED_BIT;
     }
     if (Contains(info.BindFlags, RenderBindFlags::StorageTexture))
     {
-        usage_flags |= VK_IMAGE_USAGE_STORAGE_BIT;
+        *usage |= VK_IMAGE_USAGE_STORAGE_BIT;
     }
 
-    VkFormat format = info.Format;
-    VkSampleCountFlagBits samples = info.Samples;
-
-    uint32 mips = 1;
+    *mips = 1;
     if (info.MipsEnabled)
     {
         // TODO: move to helper function
         // TODO: factor in depth for mips
-        mips = (uint32)std::floor(std::log2(std::max(info.Width, info.Height))) + 1;
+        *mips = (uint32)std::floor(std::log2(std::max(info.Width, info.Height))) + 1;
     }
+}
+
+RenderHandle Device::CreateTextureInternal(const TextureInfo& info, const MemoryHeap* heap, uint64 offset)
+{
+    AR_PROFILE_FUNCTION();
+
+    VkImageType image_type;
+    VkImageViewType view_type;
+    VkFlags flags;
+    VkImageUsageFlags usage_flags;
+    uint32 mips;
+    GetImageParameters(info, &image_type, &view_type, &flags, &usage_flags, &mips);
+
+    VkFormat format = info.Format;
+    VkSampleCountFlagBits samples = info.Samples;
 
     VkImage image;
     VkDeviceMemory memory;
@@ -747,7 +832,16 @@ RenderHandle Device::CreateTexture(const TextureInfo& info)
     std::vector<VkImageView> view_layers;
     std::vector<VkImageView> view_levels;
 
-    CreateRawImage(&image, &memory, image_type, info.Width, info.Height, info.Depth, mips, info.Layers, format, usage_flags, samples, flags, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+    if (heap)
+    {
+        CreateRawUnboundImage(&image, image_type, info.Width, info.Height, info.Depth, mips, info.Layers, format, usage_flags, samples, flags);
+        VK_CALL(vkBindImageMemory(m_Handle, image, heap->Memory, offset));
+        memory = heap->Memory;
+    }
+    else
+    {
+        CreateRawImage(&image, &memory, image_type, info.Width, info.Height, info.Depth, mips, info.Layers, format, usage_flags, samples, flags, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+    }
 
     CreateRawImageView(&view, image, view_type, format, 0, mips, 0, info.Layers);
 
@@ -778,6 +872,7 @@ RenderHandle Device::CreateTexture(const TextureInfo& info)
     resource.ImageViewLayers = view_layers;
     resource.ImageViewLevels = view_levels;
     resource.Mips = mips;
+    resource.OwnsMemory = heap == nullptr;
 
     RenderHandle render_handle = m_RenderHandleAllocator->Allocate(RenderHandleType::Texture);
     m_TextureStorage.Add(render_handle, resource);
@@ -925,7 +1020,10 @@ void Device::DestroyTexture(RenderHandle texture_handle)
     if (!texture->IsSwapchainTexture)
     {
         GetFrame()->ImagesToDestroy.push_back(texture->Image);
-        GetFrame()->MemoryToFree.push_back(texture->Memory);
+        if (texture->OwnsMemory)
+        {
+            GetFrame()->MemoryToFree.push_back(texture->Memory);
+        }
     }
     for (auto& layer : texture->ImageViewLayers)
     {
@@ -1533,6 +1631,8 @@ RenderHandle Device::CreateDescriptorSet(const DescriptorSetLayout& layout)
 {
     AR_PROFILE_FUNCTION();
 
+    // Descriptor pools of the layouts are shared by all threads
+    std::lock_guard<std::mutex> lock(m_DescriptorSetMutex);
     DescriptorSetLayoutInternal* internal = m_DescriptorSetLayoutInternalCache.RequestPointer(layout);
 
     DescriptorSet resource;
@@ -1617,6 +1717,7 @@ void Device::DestroyDescriptorSet(RenderHandle descriptor_set_handle)
 
     DescriptorSet* descriptor_set = GetDescriptorSet(descriptor_set_handle);
 
+    std::lock_guard<std::mutex> lock(m_DescriptorSetMutex);
     GetFrame()->DescriptorSetsToRelease.push_back(*descriptor_set);
 
     m_RenderHandleAllocator->Release(descriptor_set_handle);
@@ -1652,7 +1753,7 @@ void Device::CreateRawBuffer(VkBuffer* buffer, VkDeviceMemory* memory, VkDeviceS
     std::string name;
 }
 
-void Device::CreateRawImage(VkImage* image, VkDeviceMemory* memory, VkImageType type, uint32 width, uint32 height, uint32 depth, uint32 mips, uint32 layers, VkFormat format, VkImageUsageFlags usage, VkSampleCountFlagBits samples, VkFlags flags, VkMemoryPropertyFlags memory_properties)
+void Device::CreateRawUnboundImage(VkImage* image, VkImageType type, uint32 width, uint32 height, uint32 depth, uint32 mips, uint32 layers, VkFormat format, VkImageUsageFlags usage, VkSampleCountFlagBits samples, VkFlags flags)
 {
     AR_PROFILE_FUNCTION();
 
@@ -1673,6 +1774,13 @@ void Device::CreateRawImage(VkImage* image, VkDeviceMemory* memory, VkImageType
     ci.samples = samples;
     ci.flags = flags;
     VK_CALL(vkCreateImage(m_Handle, &ci, nullptr, image));
+}
+
+void Device::CreateRawImage(VkImage* image, VkDeviceMemory* memory, VkImageType type, uint32 width, uint32 height, uint32 depth, uint32 mips, uint32 layers, VkFormat format, VkImageUsageFlags usage, VkSampleCountFlagBits samples, VkFlags flags, VkMemoryPropertyFlags memory_properties)
+{
+    AR_PROFILE_FUNCTION();
+
+    CreateRawUnboundImage(image, type, width, height, depth, mips, layers, format, usage, samples, flags);
 
     // Allocate memory for image
     VkMemoryRequirements memory_requirements;
@@ -1,11 +1,13 @@
 #pragma once
 
 #include <vector>
+#include <mutex>
 
 #include <vulkan/vulkan.h>
 
 #include "Artifice/Core/Core.h"
 #include "Artifice/Core/Cache.h"
+#include "Artifice/Core/JobSystem.h"
 #include "Artifice/Debug/Instrumentor.h"
 
 #include "Artifice/Graphics/CommandBuffer.h"
@@ -80,6 +82,7 @@ public:
     }
 };
 
+// Recycles binary semaphores, they are only released once the frames using them are done and they are unsignaled
 class SemaphoreAllocator
 {
 private:
@@ -90,6 +93,14 @@ public:
     {
         m_Device = device;
     }
+    void CleanUp()
+    {
+        for (VkSemaphore semaphore : m_FreeSemaphores)
+        {
+            vkDestroySemaphore(m_Device, semaphore, nullptr);
+        }
+        m_FreeSemaphores.clear();
+    }
     VkSemaphore GetSemaphore()
     {
         VkSemaphore result;
@@ -114,23 +125,43 @@ public:
 };
 
 
+// Command pools and scratch buffers of one thread, so render graph passes can record in parallel without locking
+struct FrameThread
+{
+    CommandPool UniversalCommandPool;
+    CommandPool ComputeCommandPool;
+
+    ScratchBufferAllocator ScratchVertexAllocator;
+    ScratchBufferAllocator ScratchIndexAllocator;
+    ScratchBufferAllocator ScratchUniformAllocator;
+    ScratchBufferAllocator ScratchStorageAllocator;
+
+    void Reset()
+    {
+        // Reset command pools
+        UniversalCommandPool.Reset();
+        ComputeCommandPool.Reset();
+
+        // Reset scratch buffer allocators
+        ScratchVertexAllocator.Reset();
+        ScratchIndexAllocator.Reset();
+        ScratchUniformAllocator.Reset();
+        ScratchStorageAllocator.Reset();
+    }
+};
+
 struct Frame
 {
     VkDevice Device;
 
-    CommandPool UniversalCommandPool;
-    CommandPool ComputeCommandPool;
+    // Indexed by JobSystem::GetThreadIndex()
+    std::vector<FrameThread> Threads;
     std::vector<VkCommandBuffer> CommitedUniversalCommandBuffers;
     std::vector<VkCommandBuffer> CommitedComputeCommandBuffers;
 
     FencePool GeneralFencePool;
     FencePool TransferFencePool;
 
-    ScratchBufferAllocator ScratchVertexAllocator;
-    ScratchBufferAllocator ScratchIndexAllocator;
-    ScratchBufferAllocator ScratchUniformAllocator;
-    ScratchBufferAllocator ScratchStorageAllocator;
-
     std::vector<VkBuffer> BuffersToDestroy;
     std::vector<VkImage> ImagesToDestroy;
     std::vector<VkImageView> ImageViewsToDestroy;
@@ -139,11 +170,14 @@ struct Frame
     std::vector<VkFramebuffer> FramebuffersToDestroy;
     std::vector<VkRenderPass> RenderPassesToDestroy;
     std::vector<VkSemaphore> SemaphoresToDestroy;
+    std::vector<VkEvent> EventsToDestroy;
     std::vector<VkDeviceMemory> MemoryToFree;
 
     std::vector<DescriptorSet> DescriptorSetsToRelease;
+    std::vector<VkSemaphore> SemaphoresToRelease;
     // Temporary hack
     DescriptorSetLayoutInternalCache* DescriptorSetLayoutInternalCache;
+    SemaphoreAllocator* SemaphoreAllocator;
 
     void Begin()
     {
@@ -153,15 +187,10 @@ struct Frame
         GeneralFencePool.WaitForFences();
         TransferFencePool.WaitForFences();
 
-        // Reset command pools
-        UniversalCommandPool.Reset();
-        ComputeCommandPool.Reset();
-
-        // Reset scratch buffer allocators
-        ScratchVertexAllocator.Reset();
-        ScratchIndexAllocator.Reset();
-        ScratchUniformAllocator.Reset();
-        ScratchStorageAllocator.Reset();
+        for (auto& thread : Threads)
+        {
+            thread.Reset();
+        }
 
         // Deferred destroy of resources
 
@@ -197,6 +226,10 @@ struct Frame
         {
             vkDestroySemaphore(Device, semaphore, nullptr);
         }
+        for (auto& event : EventsToDestroy)
+        {
+            vkDestroyEvent(Device, event, nullptr);
+        }
         for (auto& memory : MemoryToFree)
         {
             vkFreeMemory(Device, memory, nullptr);
@@ -210,6 +243,7 @@ struct Frame
         FramebuffersToDestroy.clear();
         RenderPassesToDestroy.clear();
         SemaphoresToDestroy.clear();
+        EventsToDestroy.clear();
         MemoryToFree.clear();
 
         for (auto& set : DescriptorSetsToRelease)
@@ -217,6 +251,12 @@ struct Frame
             DescriptorSetLayoutInternalCache->RequestPointer(set.DescriptorSetLayout)->ReleaseDescriptorSet(set.DescriptorSetRaw);
         }
         DescriptorSetsToRelease.clear();
+
+        for (auto& semaphore : SemaphoresToRelease)
+        {
+            SemaphoreAllocator->ReleaseSemaphore(semaphore);
+        }
+        SemaphoresToRelease.clear();
     }
 };
 
@@ -324,8 +364,11 @@ private:
     RenderHandleResourceStorage<RenderHandleType::DescriptorSet, DescriptorSet> m_DescriptorSetStorage;
 
     DescriptorSetLayoutInternalCache m_DescriptorSetLayoutInternalCache;
+    SemaphoreAllocator m_SemaphoreAllocator;
 
-    DescriptorSetCache m_DescriptorSetCache;
+    // One per thread, descriptor set creation itself is guarded by m_DescriptorSetMutex
+    std::vector<DescriptorSetCache> m_DescriptorSetCaches;
+    std::mutex m_DescriptorSetMutex;
 
 
     VkSampleCountFlagBits m_MaxMSAASamples;
@@ -334,6 +377,7 @@ private:
 
     Frame m_Frames[AR_FRAME_COUNT];
     uint32 m_FrameIndex = 0;
+    uint32 m_ThreadCount = 1;
 public:
     VkSampleCountFlagBits GetMaxSamples() const { return m_MaxMSAASamples; }
 
@@ -342,7 +386,8 @@ public:
     ~Device();
 
 public:
-    void Init(VkInstance instance, RenderHandleAllocator<AR_HANDLE_RING_SIZE>* allocator);
+    // thread_count is the number of threads recording commands, see JobSystem::GetThreadCount()
+    void Init(VkInstance instance, RenderHandleAllocator<AR_HANDLE_RING_SIZE>* allocator, uint32 thread_count = 1);
     void CleanUp();
 
     inline VkDevice GetHandle() const { return m_Handle; }
@@ -360,12 +405,27 @@ public:
     {
         m_FrameIndex = (m_FrameIndex + 1) % AR_FRAME_COUNT;
         GetFrame()->Begin();
-        m_DescriptorSetCache.Advance();
+        for (auto& cache : m_DescriptorSetCaches)
+        {
+            cache.Advance();
+        }
     }
     void EndFrame()
     {
     }
     Frame* GetFrame() { return &m_Frames[m_FrameIndex]; }
+    // Index of the calling thread into the per thread state of the device
+    uint32 GetThreadIndex() const
+    {
+        uint32 thread_index = JobSystem::GetThreadIndex();
+        AR_CORE_ASSERT(thread_index < m_ThreadCount, "Device used from more threads than it was created for");
+        return thread_index;
+    }
+    FrameThread* GetFrameThread()
+    {
+        return &GetFrame()->Threads[GetThreadIndex()];
+    }
+    uint32 GetThreadCount() const { return m_ThreadCount; }
     uint32 GetFrameIndex() const { return m_FrameIndex; }
 
     void SetVSync(bool vsync) { m_VSync = vsync; }
@@ -384,7 +444,13 @@ public: // RESOURCES
     void DestroyBuffer(RenderHandle buffer_handle);
     // Textures
     RenderHandle CreateTexture(const TextureInfo& info);
+    // Texture bound to heap memory at offset, the heap must outlive it
+    RenderHandle CreatePlacedTexture(const TextureInfo& info, const MemoryHeap& heap, uint64 offset);
+    MemoryRequirements GetTextureMemoryRequirements(const TextureInfo& info);
     void DestroyTexture(RenderHandle texture_handle);
+    // Device local memory heaps
+    MemoryHeap AllocateMemoryHeap(uint64 size, uint32 memory_type_bits);
+    void FreeMemoryHeap(const MemoryHeap& heap);
     // Helpers -- user uploads happen via command buffers
     void UploadBufferData(VkCommandBuffer cmd, RenderHandle buffer_handle, uint64 size, const void* data);
     void UploadTextureData(VkCommandBuffer cmd, RenderHandle texture_handle, uint64 size, const void* data);
@@ -414,32 +480,59 @@ public: // RESOURCES
     void UpdateDescriptorSet(RenderHandle descriptor_set, const DescriptorSetUpdate& info);
     void DestroyDescriptorSet(RenderHandle descriptor_set_handle);
 
-    DescriptorSetCache* GetDescriptorSetCache() { return &m_DescriptorSetCache; }
+    DescriptorSetCache* GetDescriptorSetCache() { return &m_DescriptorSetCaches[GetThreadIndex()]; }
 
     // Scratch resources
     ScratchBuffer RequestVertexScratchBuffer(uint64 size)
     {
-        return GetFrame()->ScratchVertexAllocator.Allocate(size);
+        return GetFrameThread()->ScratchVertexAllocator.Allocate(size);
     }
     ScratchBuffer RequestIndexScratchBuffer(uint64 size)
     {
-        return GetFrame()->ScratchIndexAllocator.Allocate(size);
+        return GetFrameThread()->ScratchIndexAllocator.Allocate(size);
     }
     ScratchBuffer RequestUniformScratchBuffer(uint64 size, uint32 count = 1)
     {
-        return GetFrame()->ScratchUniformAllocator.Allocate(size, count);
+        return GetFrameThread()->ScratchUniformAllocator.Allocate(size, count);
     }
     ScratchBuffer RequestStorageScratchBuffer(uint64 size, uint32 count = 1)
     {
-        return GetFrame()->ScratchStorageAllocator.Allocate(size, count);
+        return GetFrameThread()->ScratchStorageAllocator.Allocate(size, count);
     }
 
 public:
-    // TODO: semaphore management
     void DestroySemaphore(VkSemaphore semaphore)
     {
         GetFrame()->SemaphoresToDestroy.push_back(semaphore);
     }
+    // Pooled semaphores, released ones are reused once this frame is done
+    VkSemaphore RequestSemaphore()
+    {
+        return m_SemaphoreAllocator.GetSemaphore();
+    }
+    void ReleaseSemaphore(VkSemaphore semaphore)
+    {
+        GetFrame()->SemaphoresToRelease.push_back(semaphore);
+    }
+
+    // Events for split barriers, see CommandBuffer::SetEvent
+    VkEvent CreateBarrierEvent()
+    {
+        VkEvent event;
+        VkEventCreateInfo event_ci = {};
+        event_ci.sType = VK_STRUCTURE_TYPE_EVENT_CREATE_INFO;
+        VK_CALL(vkCreateEvent(m_Handle, &event_ci, nullptr, &event));
+        return event;
+    }
+    // Only while no submitted commands use the event, like after the fences of its frame were waited on
+    void ResetBarrierEvent(VkEvent event)
+    {
+        VK_CALL(vkResetEvent(m_Handle, event));
+    }
+    void DestroyBarrierEvent(VkEvent event)
+    {
+        GetFrame()->EventsToDestroy.push_back(event);
+    }
 public: // Command buffers, queues, submission, and scheduling
     // Semaphore ops
 
@@ -506,9 +599,9 @@ public: // Command buffers, queues, submission, and scheduling
         switch (type)
         {
             case QueueType::Universal:
-                return CommandBuffer(this, type, GetFrame()->UniversalCommandPool.GetCommandBuffer());
+                return CommandBuffer(this, type, GetFrameThread()->UniversalCommandPool.GetCommandBuffer());
             case QueueType::Compute:
-                return CommandBuffer(this, type, GetFrame()->ComputeCommandPool.GetCommandBuffer());
+                return CommandBuffer(this, type, GetFrameThread()->ComputeCommandPool.GetCommandBuffer());
             default:
                 AR_CORE_FATAL("");
         }
@@ -651,6 +744,11 @@ private:
     // Helpers
     void CreateRawBuffer(VkBuffer* buffer, VkDeviceMemory* memory, VkDeviceSize size, VkBufferUsageFlags usage, VkMemoryPropertyFlags memory_properties);
     void CreateRawImage(VkImage* image, VkDeviceMemory* memory, VkImageType type, uint32 width, uint32 height, uint32 depth, uint32 mips, uint32 layers, VkFormat format, VkImageUsageFlags usage, VkSampleCountFlagBits samples, VkFlags flags, VkMemoryPropertyFlags memory_properties);
+    // Image without memory bound to it
+    void CreateRawUnboundImage(VkImage* image, VkImageType type, uint32 width, uint32 height, uint32 depth, uint32 mips, uint32 layers, VkFormat format, VkImageUsageFlags usage, VkSampleCountFlagBits samples, VkFlags flags);
+    // Vulkan image parameters of a texture
+    void GetImageParameters(const TextureInfo& info, VkImageType* image_type, VkImageViewType* view_type, VkFlags* flags, VkImageUsageFlags* usage, uint32* mips);
+    RenderHandle CreateTextureInternal(const TextureInfo& info, const MemoryHeap* heap, uint64 offset);
     void CreateRawImageView(VkImageView* view, VkImage image, VkImageViewType type, VkFormat format, uint32 base_mip, uint32 mips, uint32 base_layer, uint32 layers);
     void CreateRawSampler(VkSampler* sampler, VkFilter filter, VkSamplerAddressMode mode, VkSamplerMipmapMode mip_mode, uint32 mips);
     void CreateRawRenderPass(VkRenderPass* render_pass, uint32 attachment_count, VkAttachmentDescription* attachments, uint32 color_count, VkAttachmentReference* color_refs, VkAttachmentReference* resolve_refs, VkAttachmentReference* depth_ref);
@@ -28,12 +28,12 @@ void RenderBackend::CleanUp()
     delete m_RenderHandleAllocator;
 }
 
-DeviceID RenderBackend::CreateDevice()
+DeviceID RenderBackend::CreateDevice(uint32 thread_count)
 {
     uint32 id = BIT(m_Devices.size());
     
     Device* device = new Device();
-    device->Init(m_Instance.GetHandle(), m_RenderHandleAllocator);
+    device->Init(m_Instance.GetHandle(), m_RenderHandleAllocator, thread_count);
     m_Devices.push_back(device);
     
     return id;
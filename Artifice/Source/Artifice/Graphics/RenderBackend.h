@@ -65,7 +65,8 @@ public:
     void Init();
     void CleanUp();
 
-    DeviceID CreateDevice();
+    // thread_count is the number of threads that record commands for the device
+    DeviceID CreateDevice(uint32 thread_count = 1);
     // Default device is BIT(0)
     Device* GetDevice(DeviceID id = BIT(0))
     {
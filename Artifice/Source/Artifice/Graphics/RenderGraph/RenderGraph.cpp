@@ -1,77 +1,146 @@
 #include "RenderGraph.h"
 
+#include <algorithm>
+#include <queue>
+
 #include "Artifice/Debug/Instrumentor.h"
 #include "Artifice/Utils/Timer.h"
 
+#include "RenderGraphSubgraph.h"
+
 
-void RenderGraphPass::ClearSynchronizationStructures()
+void RenderGraphPassSynchronization::Clear()
 {
     AR_PROFILE_FUNCTION();
 
     WaitSemaphores.clear();
     WaitStages.clear();
     SignalSemaphores.clear();
+    AliasingBarriers.clear();
     TextureBarriers.clear();
     BufferBarriers.clear();
     ReleaseTextureBarriers.clear();
     ReleaseBufferBarriers.clear();
     AcquireTextureBarriers.clear();
     AcquireBufferBarriers.clear();
+    WaitSplitBarriers.clear();
+    SignalSplitBarriers.clear();
 }
 
-void RenderGraphPass::EvaluateInternal(RenderGraphRenderPassCache* render_pass_cache, RenderGraphFramebufferCache* framebuffer_cache, RenderGraphRegistry* registry, CommandBuffer* cmd, Device* device)
+void RenderGraphPass::Prepare(RenderGraphRenderPassCache* render_pass_cache, RenderGraphFramebufferCache* framebuffer_cache, RenderGraphRegistry* registry, Device* device)
 {
     AR_PROFILE_FUNCTION();
 
-    // Pre barriers
-    for (auto& barrier : AcquireTextureBarriers)
+    // The last use of this frame's events is done, the device waited for the frame
+    for (SplitBarrier& split : Sync.WaitSplitBarriers)
+    {
+        device->ResetBarrierEvent(split.Events[device->GetFrameIndex()]);
+    }
+
+    // Resources are created on first use, after this Record only reads the registry
+    for (auto* snapshots : {&BuilderPass.TextureReads, &BuilderPass.TextureWrites, &BuilderPass.TextureReadWrites})
+    {
+        for (RenderGraphResourceSnapshot& snap : *snapshots)
+        {
+            registry->GetTexture(snap.Index);
+        }
+    }
+    for (auto* snapshots : {&BuilderPass.BufferReads, &BuilderPass.BufferWrites, &BuilderPass.BufferReadWrites})
+    {
+        for (RenderGraphResourceSnapshot& snap : *snapshots)
+        {
+            registry->GetBuffer(snap.Index);
+        }
+    }
+
+    if (BuilderPass.Type != RenderGraphPassType::Render)
+    {
+        return;
+    }
+
+    // Means real render pass
+    PreparedClearValues.clear();
+    FramebufferInfo fb;
+    fb.RenderPassLayout = RenderPassInfo.Layout;
+    fb.Width = registry->GetTextureInfo(BuilderPass.ColorAttachments[0]).Width;
+    fb.Height = registry->GetTextureInfo(BuilderPass.ColorAttachments[0]).Height;
+    for (uint32 i = 0; i < BuilderPass.ColorAttachments.size(); i++)
+    {
+        fb.ColorTextures[i] = registry->GetTexture(BuilderPass.ColorAttachments[i]);
+        fb.Layers[i] = BuilderPass.ColorLayers[i];
+        vec4 c = BuilderPass.ColorClearColors[i];
+        PreparedClearValues.push_back({c.x, c.y, c.z, c.w});
+    }
+    for (uint32 i = 0; i < BuilderPass.ResolveAttachments.size(); i++)
+    {
+        fb.ResolveTextures[i] = registry->GetTexture(BuilderPass.ResolveAttachments[i]);
+        PreparedClearValues.push_back({0, 0, 0, 0});
+    }
+    for (uint32 i = 0; i < BuilderPass.DepthAttachment.size(); i++)
+    {
+        fb.DepthTexture[i] = registry->GetTexture(BuilderPass.DepthAttachment[i]);
+        PreparedClearValues.push_back({1.0f, 0});
+    }
+
+    PreparedRenderPass = render_pass_cache->Request(RenderPassInfo);
+    PreparedFramebuffer = framebuffer_cache->Request(fb);
+}
+
+void RenderGraphPass::Record(RenderGraphRegistry* registry, CommandBuffer* cmd, uint32 frame_index)
+{
+    AR_PROFILE_FUNCTION();
+
+    auto add_split = [registry, cmd](const SplitBarrier& split, BarrierBatch* batch) {
+        for (auto& barrier : split.TextureBarriers)
+        {
+            cmd->AddTextureBarrier(batch, registry->GetTexture(barrier.Resource), barrier.Source, barrier.Destination);
+        }
+        for (auto& barrier : split.BufferBarriers)
+        {
+            cmd->AddBufferBarrier(batch, registry->GetBuffer(barrier.Resource), barrier.Source, barrier.Destination);
+        }
+    };
+
+    // Pre barriers, the split ones in one wait for all their events, the others in one batch
+    std::vector<VkEvent> wait_events;
+    BarrierBatch wait_barriers;
+    for (auto& split : Sync.WaitSplitBarriers)
+    {
+        wait_events.push_back(split.Events[frame_index]);
+        add_split(split, &wait_barriers);
+    }
+    cmd->WaitEvents(wait_events, wait_barriers);
+    BarrierBatch pre_barriers;
+    for (auto& barrier : Sync.AliasingBarriers)
     {
         RenderHandle texture = registry->GetTexture(barrier.Resource);
-        cmd->AcquireTextureQueueOwnership(barrier.SourceQueue, BuilderPass.Queue, texture, barrier.Source, barrier.Destination);
+        cmd->AddAliasingBarrier(&pre_barriers, texture, barrier.Source, barrier.Destination);
     }
-    for (auto& barrier : AcquireBufferBarriers)
+    for (auto& barrier : Sync.AcquireTextureBarriers)
+    {
+        RenderHandle texture = registry->GetTexture(barrier.Resource);
+        cmd->AddAcquireTextureQueueOwnership(&pre_barriers, barrier.SourceQueue, BuilderPass.Queue, texture, barrier.Source, barrier.Destination);
+    }
+    for (auto& barrier : Sync.AcquireBufferBarriers)
     {
         RenderHandle buffer = registry->GetBuffer(barrier.Resource);
-        cmd->AcquireBufferQueueOwnership(barrier.SourceQueue, BuilderPass.Queue, buffer, barrier.Destination);
+        cmd->AddAcquireBufferQueueOwnership(&pre_barriers, barrier.SourceQueue, BuilderPass.Queue, buffer, barrier.Destination);
     }
-    for (auto& barrier : TextureBarriers)
+    for (auto& barrier : Sync.TextureBarriers)
     {
         RenderHandle texture = registry->GetTexture(barrier.Resource);
-        cmd->TextureBarrier(texture, barrier.Source, barrier.Destination);
+        cmd->AddTextureBarrier(&pre_barriers, texture, barrier.Source, barrier.Destination);
     }
-    for (auto& barrier : BufferBarriers)
+    for (auto& barrier : Sync.BufferBarriers)
     {
         RenderHandle buffer = registry->GetBuffer(barrier.Resource);
-        cmd->BufferBarrier(buffer, barrier.Source, barrier.Destination);
+        cmd->AddBufferBarrier(&pre_barriers, buffer, barrier.Source, barrier.Destination);
     }
+    cmd->PipelineBarrier(pre_barriers);
     // Evaluate
     if (BuilderPass.Type == RenderGraphPassType::Render)
     {
-        // Means real render pass
-        std::vector<VkClearValue> clear;
-        FramebufferInfo fb;
-        fb.RenderPassLayout = RenderPassInfo.Layout;
-        fb.Width = registry->GetTextureInfo(BuilderPass.ColorAttachments[0]).Width;
-        fb.Height = registry->GetTextureInfo(BuilderPass.ColorAttachments[0]).Height;
-        for (uint32 i = 0; i < BuilderPass.ColorAttachments.size(); i++)
-        {
-            fb.ColorTextures[i] = registry->GetTexture(BuilderPass.ColorAttachments[i]);
-            fb.Layers[i] = BuilderPass.ColorLayers[i];
-            vec4 c = BuilderPass.ColorClearColors[i];
-            clear.push_back({c.x, c.y, c.z, c.w});
-        }
-        for (uint32 i = 0; i < BuilderPass.ResolveAttachments.size(); i++)
-        {
-            fb.ResolveTextures[i] = registry->GetTexture(BuilderPass.ResolveAttachments[i]);
-            clear.push_back({0, 0, 0, 0});
-        }
-        for (uint32 i = 0; i < BuilderPass.DepthAttachment.size(); i++)
-        {
-            fb.DepthTexture[i] = registry->GetTexture(BuilderPass.DepthAttachment[i]);
-            clear.push_back({1.0f, 0});
-        }
-
-        cmd->BeginRenderPass(render_pass_cache->Request(RenderPassInfo), framebuffer_cache->Request(fb), clear);
+        cmd->BeginRenderPass(PreparedRenderPass, PreparedFramebuffer, PreparedClearValues);
         Evaluate(registry, cmd);
         cmd->EndRenderPass();
     }
@@ -81,39 +150,61 @@ void RenderGraphPass::EvaluateInternal(RenderGraphRenderPassCache* render_pass_c
         Evaluate(registry, cmd);
     }
     // Post barriers
-    for (auto& barrier : ReleaseTextureBarriers)
+    BarrierBatch post_barriers;
+    for (auto& barrier : Sync.ReleaseTextureBarriers)
     {
         RenderHandle texture = registry->GetTexture(barrier.Resource);
-        cmd->ReleaseTextureQueueOwnership(BuilderPass.Queue, barrier.DestinationQueue, texture, barrier.Source, barrier.Destination);
+        cmd->AddReleaseTextureQueueOwnership(&post_barriers, BuilderPass.Queue, barrier.DestinationQueue, texture, barrier.Source, barrier.Destination);
     }
-    for (auto& barrier : ReleaseBufferBarriers)
+    for (auto& barrier : Sync.ReleaseBufferBarriers)
     {
         RenderHandle buffer = registry->GetBuffer(barrier.Resource);
-        cmd->ReleaseBufferQueueOwnership(BuilderPass.Queue, barrier.DestinationQueue, buffer, barrier.Source);
+        cmd->AddReleaseBufferQueueOwnership(&post_barriers, BuilderPass.Queue, barrier.DestinationQueue, buffer, barrier.Source);
+    }
+    cmd->PipelineBarrier(post_barriers);
+    for (auto& split : Sync.SignalSplitBarriers)
+    {
+        BarrierBatch batch;
+        add_split(split, &batch);
+        cmd->SetEvent(split.Events[frame_index], batch);
     }
 }
 
 
 // RENDER GRAPH
 
-RenderGraph::RenderGraph(Device* device) : m_Device(device)
+RenderGraph::RenderGraph(Device* device)
 {
-    m_Registry.Init(device);
-    m_RenderPassCache.Init(device);
-    m_FramebufferCache.Init(device);
+    Init(device);
 }
 
 void RenderGraph::Init(Device* device)
 {
     m_Device = device;
+    m_DeviceAdapter = RenderGraphDeviceAdapter(device);
+    m_GraphDevice = &m_DeviceAdapter;
     m_Registry.Init(device);
     m_RenderPassCache.Init(device);
     m_FramebufferCache.Init(device);
+    m_TransientAllocator.Init(device, m_GraphDevice);
+}
+
+void RenderGraph::InitHeadless(RenderGraphDevice* graph_device)
+{
+    // The caches are only used when evaluating
+    m_Device = nullptr;
+    m_GraphDevice = graph_device;
+    m_Registry.Init(nullptr);
+    m_RenderPassCache.Init(nullptr);
+    m_FramebufferCache.Init(nullptr);
+    m_TransientAllocator.Init(nullptr, graph_device);
 }
 
 void RenderGraph::CleanUp()
 {
     Reset();
+    DestroyCompiledSync();
+    m_TransientAllocator.CleanUp();
     m_Registry.CleanUp();
     m_RenderPassCache.Reset();
     m_FramebufferCache.Reset();
@@ -124,18 +215,15 @@ void RenderGraph::Reset()
     AR_PROFILE_FUNCTION();
 
     m_Blackboard.Reset();
-    
-    for (auto& pass : m_Passes)
-    {
-        for (auto& sem : pass.SignalSemaphores)
-        {
-            m_Device->DestroySemaphore(sem);
-        }
-    }
+
+    // Semaphores are owned by m_CompiledSync, they are kept for the next frame if its structure is the same
     m_Passes.clear();
     m_Registry.Clear();
     m_TextureLifetimes.clear();
     m_BufferLifetimes.clear();
+    m_StructureHash = FNV_OFFSET_BASIS_64;
+    m_Subgraphs.clear();
+    m_SubgraphsEvaluated = false;
 
     m_Registry.Advance();
     m_RenderPassCache.Advance();
@@ -146,13 +234,29 @@ void RenderGraph::AddPass(const std::string& name, RenderGraphPass::Construction
 {
     AR_PROFILE_FUNCTION();
 
-    RenderGraphBuilder builder(m_Device, &m_Registry);
+    RenderGraphBuilder builder(m_GraphDevice, &m_Registry);
 
     RenderGraphPass pass;
     pass.Name = name;
     pass.Evaluate = construct(&builder);
     pass.BuilderPass = builder.GetPass();
     pass.RenderPassInfo = builder.GetRenderPassInfo();
+    pass.StructureHash = HashPassStructure(pass.BuilderPass);
+
+    Hasher hasher(m_StructureHash);
+    hasher.u64(pass.StructureHash);
+    m_StructureHash = hasher.GetHash();
+
+    // The queue is only known once the pass is constructed. Read on another queue, the output would need an
+    // ownership transfer the graph doesn't know about.
+    for (const RenderGraphSubgraphUse& use : pass.BuilderPass.Subgraphs)
+    {
+        AR_CORE_ASSERT(use.Queue == pass.BuilderPass.Queue, "Tried reading subgraph output on another queue than it was handed to");
+        if (std::find(m_Subgraphs.begin(), m_Subgraphs.end(), use.Subgraph) == m_Subgraphs.end())
+        {
+            m_Subgraphs.push_back(use.Subgraph);
+        }
+    }
 
     m_Passes.push_back(pass);
 }
@@ -161,74 +265,210 @@ void RenderGraph::Compile()
 {
     AR_PROFILE_FUNCTION();
 
-    uint32 rp_count = 0;
-    std::vector<std::string> pass_names;
-
     Timer timer;
 
-    ConstructResourceLifetimes();
-    for (auto& pass : m_Passes)
+    // Bind flags are only final after every pass is added, and sizes decide the transient memory layout. Imported
+    // textures are never culled or placed in transient memory.
+    Hasher hasher(m_StructureHash);
+    for (uint32 i = 0; i < m_Registry.GetTextureCount(); i++)
+    {
+        RenderGraphTransientAllocator::HashTextureInfo(hasher, m_Registry.GetTextureInfo(i));
+        hasher.u32(m_Registry.IsTextureImported(i));
+    }
+    uint64 structure_hash = hasher.GetHash();
+
+    // Same passes accessing the same resources in the same states as the last compile, so lifetimes,
+    // synchronization and transient memory are identical. Only the evaluation functions, bound in AddPass, differ.
+    bool cached = structure_hash == m_CompiledStructureHash && m_CompiledSync.size() == m_Passes.size();
+    if (cached)
     {
+        for (uint32 i = 0; i < m_Passes.size(); i++)
+        {
+            m_Passes[i].Sync = m_CompiledSync[i];
+            m_Passes[i].Culled = m_CompiledCulled[i];
+            m_Passes[i].PassDependencies = m_CompiledDependencies[i];
+        }
+    }
+    else
+    {
+        DestroyCompiledSync();
+
+        CullPasses();
+        SchedulePasses();
+        ConstructResourceLifetimes();
+        for (auto& pass : m_Passes)
+        {
+            pass.Sync.Clear();
+        }
+        ConstructSynchronizationStructures();
+        ConstructTransientTextures();
+
+        m_CompiledStructureHash = structure_hash;
+        m_CompiledSync.resize(m_Passes.size());
+        m_CompiledCulled.resize(m_Passes.size());
+        m_CompiledDependencies.resize(m_Passes.size());
+        for (uint32 i = 0; i < m_Passes.size(); i++)
+        {
+            m_CompiledSync[i] = m_Passes[i].Sync;
+            m_CompiledCulled[i] = m_Passes[i].Culled;
+            m_CompiledDependencies[i] = m_Passes[i].PassDependencies;
+        }
+    }
+
+    uint32 rp_count = 0;
+    std::vector<std::string> pass_names;
+    for (uint32 pass_index : m_ExecutionOrder)
+    {
+        RenderGraphPass& pass = m_Passes[pass_index];
         pass_names.push_back(pass.Name);
         if (pass.BuilderPass.Type == RenderGraphPassType::Render)
             rp_count++;
-        
-        pass.ClearSynchronizationStructures();
     }
-    ConstructSynchronizationStructures();
+    uint32 culled_count = m_Passes.size() - m_ExecutionOrder.size();
+
+    uint32 barrier_count = 0;
+    uint32 split_count = 0;
+    uint32 semaphore_count = 0;
+    for (uint32 pass_index : m_ExecutionOrder)
+    {
+        RenderGraphPassSynchronization& sync = m_Passes[pass_index].Sync;
+        barrier_count += sync.AliasingBarriers.size() + sync.TextureBarriers.size() + sync.BufferBarriers.size();
+        barrier_count += sync.ReleaseTextureBarriers.size() + sync.ReleaseBufferBarriers.size();
+        barrier_count += sync.AcquireTextureBarriers.size() + sync.AcquireBufferBarriers.size();
+        for (SplitBarrier& split : sync.WaitSplitBarriers)
+        {
+            split_count += split.TextureBarriers.size() + split.BufferBarriers.size();
+        }
+        semaphore_count += sync.SignalSemaphores.size();
+    }
+
+    m_Statistics = { (uint32)m_Passes.size(), culled_count, rp_count, m_Registry.GetTextureCount(), m_Registry.GetBufferCount(), timer.ElapsedMillis(), 0, 0, 0, 0, 0, pass_names, {}, cached,
+                     m_TransientAllocator.GetHeapMemory(), m_TransientAllocator.GetTextureMemory(), barrier_count + split_count, split_count, semaphore_count };
+}
+
+void RenderGraph::EvaluateSubgraphs()
+{
+    AR_PROFILE_FUNCTION();
+
+    if (m_SubgraphsEvaluated)
+    {
+        return;
+    }
 
-    m_Statistics = { (uint32)m_Passes.size(), rp_count, (uint32)m_TextureLifetimes.size(), (uint32)m_BufferLifetimes.size(), timer.ElapsedMillis(), 0, 0, 0, 0, 0, pass_names, {} };
+    // Every subgraph submits and signals before the passes reading its outputs are submitted
+    for (RenderGraphSubgraph* subgraph : m_Subgraphs)
+    {
+        subgraph->Update();
+    }
+    m_SubgraphsEvaluated = true;
 }
 
 void RenderGraph::Evaluate()
 {
     AR_PROFILE_FUNCTION();
 
-    // Scheduling
-    // Need to batch by queue submits
-    // Within each queue submit batch, can go wide
-    // Need a way to signal rendering finished semaphore for last swapchain touches
+    AR_CORE_ASSERT(m_Device, "Tried evaluating headless render graph");
 
-    // need to create dependency graph (DAG)
+    EvaluateSubgraphs();
 
     Timer timer;
+    // Graphs may be evaluated several times per compile, like subgraphs
+    m_Statistics.PassTimes.clear();
 
-    CommandBuffer cmd = m_Device->RequestCommandBuffer(QueueType::Universal);
-    QueueType current_queue = QueueType::Universal;
-    std::vector<VkSemaphore> last_signals;
-    cmd.Begin();
-    std::string name = "";
+    // Compile only plans the transient textures, this creates them for the current frame
+    m_TransientAllocator.Assign(&m_Registry);
 
-    for (auto& pass : m_Passes)
+    std::vector<RenderGraphPass*> passes;
+    for (uint32 pass_index : m_ExecutionOrder)
     {
-        if (pass.BuilderPass.Queue != current_queue || last_signals.size())
+        RenderGraphPass& pass = m_Passes[pass_index];
+        pass.Prepare(&m_RenderPassCache, &m_FramebufferCache, &m_Registry, m_Device);
+        passes.push_back(&pass);
+    }
+
+    // Every pass records into its own command buffer, from the pool of the thread recording it. Consecutive parallel
+    // passes are recorded as jobs, other passes wait for them and are recorded on this thread.
+    uint32 frame_index = m_Device->GetFrameIndex();
+    std::vector<CommandBuffer> cmds(passes.size());
+    std::vector<float> pass_times(passes.size());
+    JobCounter counter;
+    for (uint32 i = 0; i < passes.size(); i++)
+    {
+        RenderGraphPass* pass = passes[i];
+        auto record = [this, pass, &cmds, &pass_times, i, frame_index]() {
+            Timer pass_timer;
+            cmds[i] = m_Device->RequestCommandBuffer(pass->BuilderPass.Queue);
+            cmds[i].Begin();
+            pass->Record(&m_Registry, &cmds[i], frame_index);
+            cmds[i].End();
+            pass_times[i] = pass_timer.ElapsedMillis();
+        };
+
+        if (m_JobSystem && pass->BuilderPass.Parallel)
         {
-            cmd.End();
-            m_Device->CommitCommandBuffer(cmd);
-            m_Device->SubmitQueue(current_queue, {}, {}, true);
-            current_queue = pass.BuilderPass.Queue;
-            cmd = m_Device->RequestCommandBuffer(pass.BuilderPass.Queue);
-            cmd.Begin();
+            m_JobSystem->Execute(record, &counter);
+            continue;
         }
-        Timer pass_timer;
-        name = pass.Name;
-        pass.EvaluateInternal(&m_RenderPassCache, &m_FramebufferCache, &m_Registry, &cmd, m_Device);
-        last_signals = pass.SignalSemaphores;
-        for (uint32 i = 0; i < pass.WaitSemaphores.size(); i++)
+        if (m_JobSystem)
         {
-            m_Device->AddWaitSemaphore(pass.BuilderPass.Queue, pass.WaitSemaphores[i], pass.WaitStages[i]);
+            m_JobSystem->Wait(&counter);
         }
-        for (uint32 i = 0; i < pass.SignalSemaphores.size(); i++)
+        record();
+    }
+    if (m_JobSystem)
+    {
+        m_JobSystem->Wait(&counter);
+    }
+
+    // Submit in execution order, batched by queue. A batch ends after a pass signals another queue, so the other
+    // queue can start, and before a pass waits, so the passes before it don't wait too.
+    struct Batch
+    {
+        QueueType Queue;
+        uint32 Begin;
+        uint32 End;
+    };
+    std::vector<Batch> batches;
+    for (uint32 i = 0; i < passes.size(); i++)
+    {
+        RenderGraphPass* pass = passes[i];
+        bool split = batches.empty() || batches.back().Queue != pass->BuilderPass.Queue ||
+                     passes[i - 1]->Sync.SignalSemaphores.size() || pass->Sync.WaitSemaphores.size();
+        if (split)
         {
-            m_Device->AddSignalSemaphore(pass.BuilderPass.Queue, pass.SignalSemaphores[i]);
+            batches.push_back({pass->BuilderPass.Queue, i, i});
         }
-        m_Statistics.PassTimes.push_back(pass_timer.ElapsedMillis());
+        batches.back().End = i + 1;
     }
+    if (batches.empty())
+    {
+        batches.push_back({QueueType::Universal, 0, 0});
+    }
+
+    for (uint32 batch_index = 0; batch_index < batches.size(); batch_index++)
+    {
+        Batch& batch = batches[batch_index];
+        for (uint32 i = batch.Begin; i < batch.End; i++)
+        {
+            RenderGraphPass* pass = passes[i];
+            m_Device->CommitCommandBuffer(cmds[i]);
+            for (uint32 j = 0; j < pass->Sync.WaitSemaphores.size(); j++)
+            {
+                m_Device->AddWaitSemaphore(pass->BuilderPass.Queue, pass->Sync.WaitSemaphores[j], pass->Sync.WaitStages[j]);
+            }
+            for (uint32 j = 0; j < pass->Sync.SignalSemaphores.size(); j++)
+            {
+                m_Device->AddSignalSemaphore(pass->BuilderPass.Queue, pass->Sync.SignalSemaphores[j]);
+            }
+            m_Statistics.PassTimes.push_back(pass_times[i]);
+        }
 
-    cmd.End();
-    m_Device->CommitCommandBuffer(cmd);
-    
-    m_Device->SubmitQueue(current_queue, {}, {}, true);
+        // A fence covers every earlier submit to its queue, so only the last one of each queue needs one
+        bool last_on_queue = std::none_of(batches.begin() + batch_index + 1, batches.end(), [&batch](const Batch& other) {
+            return other.Queue == batch.Queue;
+        });
+        m_Device->SubmitQueue(batch.Queue, {}, {}, last_on_queue);
+    }
 
     m_Statistics.EvaluationTime = timer.ElapsedMillis();
     m_Statistics.AliveFramebufferCount = m_FramebufferCache.GetAlive();
@@ -236,6 +476,219 @@ void RenderGraph::Evaluate()
     std::pair<uint32, uint32> tex_buf_count = m_Registry.GetAlive();
     m_Statistics.AliveTextureCount = tex_buf_count.first;
     m_Statistics.AliveBufferCount = tex_buf_count.second;
+
+    // Subgraphs aren't reset between evaluations, their own subgraphs are due again next time
+    m_SubgraphsEvaluated = false;
+}
+
+void RenderGraph::CullPasses()
+{
+    AR_PROFILE_FUNCTION();
+
+    // Readers of every resource among the passes that are kept, resources are indexed textures first, then buffers.
+    // Imported textures and marked outputs are used outside the graph, so they start out referenced.
+    uint32 texture_count = m_Registry.GetTextureCount();
+    std::vector<uint32> references(texture_count + m_Registry.GetBufferCount(), 0);
+    for (uint32 i = 0; i < texture_count; i++)
+    {
+        if (m_Registry.IsTextureImported(i))
+        {
+            references[i]++;
+        }
+    }
+    for (auto& pass : m_Passes)
+    {
+        for (uint32 index : pass.BuilderPass.TextureOutputs)
+        {
+            references[index]++;
+        }
+        for (uint32 index : pass.BuilderPass.BufferOutputs)
+        {
+            references[texture_count + index]++;
+        }
+    }
+
+    // Readers come after writers, so walking backwards every reader of a resource is known before its writers
+    for (int32 pass_index = m_Passes.size() - 1; pass_index >= 0; pass_index--)
+    {
+        RenderGraphPass& pass = m_Passes[pass_index];
+        RenderGraphBuilderPass& builder_pass = pass.BuilderPass;
+
+        // Passes without declared writes may have effects the graph can't see, they are always kept
+        bool has_writes = false;
+        bool referenced = false;
+        auto check_writes = [&](const std::vector<RenderGraphResourceSnapshot>& snapshots, uint32 base) {
+            for (const RenderGraphResourceSnapshot& snap : snapshots)
+            {
+                has_writes = true;
+                referenced |= references[base + snap.Index] > 0;
+            }
+        };
+        check_writes(builder_pass.TextureWrites, 0);
+        check_writes(builder_pass.TextureReadWrites, 0);
+        check_writes(builder_pass.BufferWrites, texture_count);
+        check_writes(builder_pass.BufferReadWrites, texture_count);
+
+        pass.Culled = has_writes && !referenced;
+        if (pass.Culled)
+        {
+            continue;
+        }
+
+        auto add_references = [&](const std::vector<RenderGraphResourceSnapshot>& snapshots, uint32 base) {
+            for (const RenderGraphResourceSnapshot& snap : snapshots)
+            {
+                references[base + snap.Index]++;
+            }
+        };
+        add_references(builder_pass.TextureReads, 0);
+        add_references(builder_pass.TextureReadWrites, 0);
+        add_references(builder_pass.BufferReads, texture_count);
+        add_references(builder_pass.BufferReadWrites, texture_count);
+    }
+}
+
+void RenderGraph::SchedulePasses()
+{
+    AR_PROFILE_FUNCTION();
+
+    // Dependencies follow the AddPass order of the accesses: reads depend on the last write, writes on the last
+    // write and every read since. Resources are indexed textures first, then buffers.
+    struct ResourceUsers
+    {
+        int32 Writer = -1;
+        std::vector<uint32> Readers;
+    };
+    uint32 texture_count = m_Registry.GetTextureCount();
+    std::vector<ResourceUsers> users(texture_count + m_Registry.GetBufferCount());
+
+    // Passes without any declared access may depend on anything, they keep their place between the others
+    int32 last_opaque = -1;
+    std::vector<uint32> since_opaque;
+
+    for (uint32 pass_index = 0; pass_index < m_Passes.size(); pass_index++)
+    {
+        RenderGraphPass& pass = m_Passes[pass_index];
+        RenderGraphBuilderPass& builder_pass = pass.BuilderPass;
+        pass.PassDependencies.clear();
+        if (pass.Culled)
+        {
+            continue;
+        }
+
+        auto add_dependency = [&](int32 dependency) {
+            if (dependency >= 0 && dependency != (int32)pass_index)
+            {
+                pass.PassDependencies.insert(dependency);
+            }
+        };
+        auto add_reads = [&](const std::vector<RenderGraphResourceSnapshot>& snapshots, uint32 base) {
+            for (const RenderGraphResourceSnapshot& snap : snapshots)
+            {
+                ResourceUsers& resource = users[base + snap.Index];
+                add_dependency(resource.Writer);
+                resource.Readers.push_back(pass_index);
+            }
+        };
+        auto add_writes = [&](const std::vector<RenderGraphResourceSnapshot>& snapshots, uint32 base) {
+            for (const RenderGraphResourceSnapshot& snap : snapshots)
+            {
+                ResourceUsers& resource = users[base + snap.Index];
+                add_dependency(resource.Writer);
+                for (uint32 reader : resource.Readers)
+                {
+                    add_dependency(reader);
+                }
+                resource.Writer = pass_index;
+                resource.Readers.clear();
+            }
+        };
+        add_reads(builder_pass.TextureReads, 0);
+        add_reads(builder_pass.BufferReads, texture_count);
+        add_writes(builder_pass.TextureWrites, 0);
+        add_writes(builder_pass.TextureReadWrites, 0);
+        add_writes(builder_pass.BufferWrites, texture_count);
+        add_writes(builder_pass.BufferReadWrites, texture_count);
+
+        bool opaque = builder_pass.TextureReads.empty() && builder_pass.TextureWrites.empty() && builder_pass.TextureReadWrites.empty() &&
+                      builder_pass.BufferReads.empty() && builder_pass.BufferWrites.empty() && builder_pass.BufferReadWrites.empty();
+        add_dependency(last_opaque);
+        if (opaque)
+        {
+            for (uint32 other : since_opaque)
+            {
+                add_dependency(other);
+            }
+            last_opaque = pass_index;
+            since_opaque.clear();
+        }
+        else
+        {
+            since_opaque.push_back(pass_index);
+        }
+    }
+
+    // Topological order, picking among the passes whose dependencies are scheduled:
+    // 1. compute passes first, so async compute is submitted early and overlaps the graphics work after it
+    // 2. the pass whose latest dependency was scheduled earliest, to put distance between producers and consumers
+    // 3. AddPass order
+    struct Candidate
+    {
+        bool Compute;
+        int32 LatestDependency;
+        uint32 PassIndex;
+
+        // Lowest priority first, std::priority_queue pops the highest
+        bool operator<(const Candidate& other) const
+        {
+            if (Compute != other.Compute)
+                return !Compute;
+            if (LatestDependency != other.LatestDependency)
+                return LatestDependency > other.LatestDependency;
+            return PassIndex > other.PassIndex;
+        }
+    };
+
+    std::vector<uint32> remaining(m_Passes.size(), 0);
+    std::vector<int32> latest_dependency(m_Passes.size(), -1);
+    std::vector<std::vector<uint32>> dependents(m_Passes.size());
+    std::priority_queue<Candidate> ready;
+    for (uint32 pass_index = 0; pass_index < m_Passes.size(); pass_index++)
+    {
+        RenderGraphPass& pass = m_Passes[pass_index];
+        if (pass.Culled)
+        {
+            continue;
+        }
+        remaining[pass_index] = pass.PassDependencies.size();
+        for (uint32 dependency : pass.PassDependencies)
+        {
+            dependents[dependency].push_back(pass_index);
+        }
+        if (pass.PassDependencies.empty())
+        {
+            ready.push({pass.BuilderPass.Queue == QueueType::Compute, -1, pass_index});
+        }
+    }
+
+    m_ExecutionOrder.clear();
+    while (!ready.empty())
+    {
+        uint32 pass_index = ready.top().PassIndex;
+        ready.pop();
+
+        int32 position = m_ExecutionOrder.size();
+        m_ExecutionOrder.push_back(pass_index);
+
+        for (uint32 dependent : dependents[pass_index])
+        {
+            latest_dependency[dependent] = std::max(latest_dependency[dependent], position);
+            if (--remaining[dependent] == 0)
+            {
+                ready.push({m_Passes[dependent].BuilderPass.Queue == QueueType::Compute, latest_dependency[dependent], dependent});
+            }
+        }
+    }
 }
 
 void RenderGraph::ConstructResourceLifetimes()
@@ -245,27 +698,31 @@ void RenderGraph::ConstructResourceLifetimes()
     m_TextureLifetimes.resize(m_Registry.GetTextureCount());
     m_BufferLifetimes.resize(m_Registry.GetBufferCount());
 
-    for (uint32 pass_index = 0; pass_index < m_Passes.size(); pass_index++)
+    // Resources created by culled passes can still be used by others
+    for (auto& graph_pass : m_Passes)
     {
-        RenderGraphBuilderPass& pass = m_Passes[pass_index].BuilderPass;
+        RenderGraphBuilderPass& pass = graph_pass.BuilderPass;
         for (RenderGraphResourceSnapshot& snap : pass.TextureCreatesAndImports)
         {
-            uint32 index = m_Registry.GetIndex(snap.Name);
-            RenderGraphResourceLifetime& resource = m_TextureLifetimes[index];
-            resource.Name = snap.Name;
+            RenderGraphResourceLifetime& resource = m_TextureLifetimes[snap.Index];
+            resource.Index = snap.Index;
             resource.InitialState = snap.State;
         }
         for (RenderGraphResourceSnapshot& snap : pass.BufferCreatesAndImports)
         {
-            uint32 index = m_Registry.GetIndex(snap.Name);
-            RenderGraphResourceLifetime& resource = m_BufferLifetimes[index];
-            resource.Name = snap.Name;
+            RenderGraphResourceLifetime& resource = m_BufferLifetimes[snap.Index];
+            resource.Index = snap.Index;
             resource.InitialState = snap.State;
         }
+    }
+
+    // Accesses in execution order, the synchronization is built from consecutive accesses
+    for (uint32 pass_index : m_ExecutionOrder)
+    {
+        RenderGraphBuilderPass& pass = m_Passes[pass_index].BuilderPass;
         for (RenderGraphResourceSnapshot& snap : pass.TextureReads)
         {
-            uint32 index = m_Registry.GetIndex(snap.Name);
-            RenderGraphResourceLifetime& resource = m_TextureLifetimes[index];
+            RenderGraphResourceLifetime& resource = m_TextureLifetimes[snap.Index];
 
             RenderGraphResourceLifetime::Snapshot snapshot;
             snapshot.Access = RenderGraphResourceAccess::Read;
@@ -277,8 +734,7 @@ void RenderGraph::ConstructResourceLifetimes()
         }
         for (RenderGraphResourceSnapshot& snap : pass.TextureWrites)
         {
-            uint32 index = m_Registry.GetIndex(snap.Name);
-            RenderGraphResourceLifetime& resource = m_TextureLifetimes[index];
+            RenderGraphResourceLifetime& resource = m_TextureLifetimes[snap.Index];
 
             RenderGraphResourceLifetime::Snapshot snapshot;
             snapshot.Access = RenderGraphResourceAccess::Write;
@@ -290,8 +746,7 @@ void RenderGraph::ConstructResourceLifetimes()
         }
         for (RenderGraphResourceSnapshot& snap : pass.TextureReadWrites)
         {
-            uint32 index = m_Registry.GetIndex(snap.Name);
-            RenderGraphResourceLifetime& resource = m_TextureLifetimes[index];
+            RenderGraphResourceLifetime& resource = m_TextureLifetimes[snap.Index];
 
             RenderGraphResourceLifetime::Snapshot snapshot;
             snapshot.Access = RenderGraphResourceAccess::ReadWrite;
@@ -303,8 +758,7 @@ void RenderGraph::ConstructResourceLifetimes()
         }
         for (RenderGraphResourceSnapshot& snap : pass.BufferReads)
         {
-            uint32 index = m_Registry.GetIndex(snap.Name);
-            RenderGraphResourceLifetime& resource = m_BufferLifetimes[index];
+            RenderGraphResourceLifetime& resource = m_BufferLifetimes[snap.Index];
 
             RenderGraphResourceLifetime::Snapshot snapshot;
             snapshot.Access = RenderGraphResourceAccess::Read;
@@ -316,8 +770,7 @@ void RenderGraph::ConstructResourceLifetimes()
         }
         for (RenderGraphResourceSnapshot& snap : pass.BufferWrites)
         {
-            uint32 index = m_Registry.GetIndex(snap.Name);
-            RenderGraphResourceLifetime& resource = m_BufferLifetimes[index];
+            RenderGraphResourceLifetime& resource = m_BufferLifetimes[snap.Index];
 
             RenderGraphResourceLifetime::Snapshot snapshot;
             snapshot.Access = RenderGraphResourceAccess::Write;
@@ -329,8 +782,7 @@ void RenderGraph::ConstructResourceLifetimes()
         }
         for (RenderGraphResourceSnapshot& snap : pass.BufferReadWrites)
         {
-            uint32 index = m_Registry.GetIndex(snap.Name);
-            RenderGraphResourceLifetime& resource = m_BufferLifetimes[index];
+            RenderGraphResourceLifetime& resource = m_BufferLifetimes[snap.Index];
 
             RenderGraphResourceLifetime::Snapshot snapshot;
             snapshot.Access = RenderGraphResourceAccess::ReadWrite;
@@ -347,6 +799,24 @@ void RenderGraph::ConstructSynchronizationStructures()
 {
     AR_PROFILE_FUNCTION();
 
+    // Barriers from passes further back are split, one per pair of passes
+    std::vector<uint32> positions = GetExecutionPositions();
+    auto is_split = [&positions](uint32 source_pass, uint32 pass) {
+        return positions[pass] - positions[source_pass] > 1;
+    };
+    auto get_split = [](RenderGraphPass& pass, uint32 source_pass) {
+        for (SplitBarrier& split : pass.Sync.WaitSplitBarriers)
+        {
+            if (split.SourcePass == source_pass)
+            {
+                return &split;
+            }
+        }
+        pass.Sync.WaitSplitBarriers.push_back({});
+        pass.Sync.WaitSplitBarriers.back().SourcePass = source_pass;
+        return &pass.Sync.WaitSplitBarriers.back();
+    };
+
     // Construct texture barriers/semaphores
     for (uint32 resource_index = 0; resource_index < m_TextureLifetimes.size(); resource_index++)
     {
@@ -354,18 +824,22 @@ void RenderGraph::ConstructSynchronizationStructures()
         if (lifetime.Lifetime.empty())
         {
             continue;
-            AR_CORE_WARN("RenderGraph unused texture: %s", lifetime.Name.c_str());
+            AR_CORE_WARN("RenderGraph unused texture: %s", m_Registry.GetTextureName(resource_index).c_str());
         }
 
         RenderGraphResourceLifetime::Snapshot& first_snap = lifetime.Lifetime[0];
 
-        Barrier barrier;
-        barrier.Resource = lifetime.Name;
-        barrier.Source = lifetime.InitialState;
-        barrier.Destination = first_snap.State;
+        // Imported in the state it is read in, like the outputs of a subgraph. No barrier necessary.
+        if (lifetime.InitialState != first_snap.State || first_snap.Access != RenderGraphResourceAccess::Read)
+        {
+            Barrier barrier;
+            barrier.Resource = lifetime.Index;
+            barrier.Source = lifetime.InitialState;
+            barrier.Destination = first_snap.State;
 
-        RenderGraphPass& first_pass = m_Passes[first_snap.PassIndex];
-        first_pass.TextureBarriers.push_back(barrier);
+            RenderGraphPass& first_pass = m_Passes[first_snap.PassIndex];
+            first_pass.Sync.TextureBarriers.push_back(barrier);
+        }
 
         for (uint32 pass_it = 1; pass_it < lifetime.Lifetime.size(); pass_it++)
         {
@@ -377,32 +851,27 @@ void RenderGraph::ConstructSynchronizationStructures()
 
             if (prev_snap.Queue != curr_snap.Queue)
             {
-                // TODO: Semaphore management
-                VkSemaphore semaphore;
-                VkSemaphoreCreateInfo semaphore_ci = {};
-                semaphore_ci.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
-                VK_CALL(vkCreateSemaphore(m_Device->GetHandle(), &semaphore_ci, nullptr, &semaphore));
-                // TODO: Semaphore management
+                VkSemaphore semaphore = m_GraphDevice->RequestSemaphore();
 
-                prev_pass.SignalSemaphores.push_back(semaphore);
-                curr_pass.WaitSemaphores.push_back(semaphore);
-                curr_pass.WaitStages.push_back(curr_snap.State.Stage);
+                prev_pass.Sync.SignalSemaphores.push_back(semaphore);
+                curr_pass.Sync.WaitSemaphores.push_back(semaphore);
+                curr_pass.Sync.WaitStages.push_back(curr_snap.State.Stage);
 
                 ReleaseBarrier release;
-                release.Resource = lifetime.Name;
+                release.Resource = lifetime.Index;
                 release.Source = prev_snap.State;
                 release.Destination = curr_snap.State;
                 release.DestinationQueue = curr_snap.Queue;
 
-                prev_pass.ReleaseTextureBarriers.push_back(release);
+                prev_pass.Sync.ReleaseTextureBarriers.push_back(release);
 
                 AcquireBarrier acquire;
-                acquire.Resource = lifetime.Name;
+                acquire.Resource = lifetime.Index;
                 acquire.Source = prev_snap.State;
                 acquire.SourceQueue = prev_snap.Queue;
                 acquire.Destination = curr_snap.State;
 
-                curr_pass.AcquireTextureBarriers.push_back(acquire);
+                curr_pass.Sync.AcquireTextureBarriers.push_back(acquire);
             }
             else
             {
@@ -413,11 +882,18 @@ void RenderGraph::ConstructSynchronizationStructures()
                 }
 
                 Barrier barrier;
-                barrier.Resource = lifetime.Name;
+                barrier.Resource = lifetime.Index;
                 barrier.Source = prev_snap.State;
                 barrier.Destination = curr_snap.State;
 
-                curr_pass.TextureBarriers.push_back(barrier);
+                if (is_split(prev_snap.PassIndex, curr_snap.PassIndex))
+                {
+                    get_split(curr_pass, prev_snap.PassIndex)->TextureBarriers.push_back(barrier);
+                }
+                else
+                {
+                    curr_pass.Sync.TextureBarriers.push_back(barrier);
+                }
             }
         }
     } // End iterate texture lifetimes
@@ -429,18 +905,18 @@ void RenderGraph::ConstructSynchronizationStructures()
         if (lifetime.Lifetime.empty())
         {
             continue;
-            AR_CORE_WARN("RenderGraph unused buffer: %s", lifetime.Name.c_str());
+            AR_CORE_WARN("RenderGraph unused buffer: %s", m_Registry.GetBufferName(resource_index).c_str());
         }
 
         RenderGraphResourceLifetime::Snapshot& first_snap = lifetime.Lifetime[0];
 
         Barrier barrier;
-        barrier.Resource = lifetime.Name;
+        barrier.Resource = lifetime.Index;
         barrier.Source = lifetime.InitialState;
         barrier.Destination = first_snap.State;
 
         RenderGraphPass& first_pass = m_Passes[first_snap.PassIndex];
-        first_pass.BufferBarriers.push_back(barrier);
+        first_pass.Sync.BufferBarriers.push_back(barrier);
 
         for (uint32 pass_it = 1; pass_it < lifetime.Lifetime.size(); pass_it++)
         {
@@ -452,26 +928,26 @@ void RenderGraph::ConstructSynchronizationStructures()
 
             if (prev_snap.Queue != curr_snap.Queue)
             {
-                VkSemaphore semaphore;
-                prev_pass.SignalSemaphores.push_back(semaphore);
-                curr_pass.WaitSemaphores.push_back(semaphore);
-                curr_pass.WaitStages.push_back(curr_snap.State.Stage);
+                VkSemaphore semaphore = m_GraphDevice->RequestSemaphore();
+                prev_pass.Sync.SignalSemaphores.push_back(semaphore);
+                curr_pass.Sync.WaitSemaphores.push_back(semaphore);
+                curr_pass.Sync.WaitStages.push_back(curr_snap.State.Stage);
 
                 ReleaseBarrier release;
-                release.Resource = lifetime.Name;
+                release.Resource = lifetime.Index;
                 release.Source = prev_snap.State;
                 release.Destination = curr_snap.State;
                 release.DestinationQueue = curr_snap.Queue;
 
-                prev_pass.ReleaseBufferBarriers.push_back(release);
+                prev_pass.Sync.ReleaseBufferBarriers.push_back(release);
 
                 AcquireBarrier acquire;
-                acquire.Resource = lifetime.Name;
+                acquire.Resource = lifetime.Index;
                 acquire.Source = prev_snap.State;
                 acquire.SourceQueue = prev_snap.Queue;
                 acquire.Destination = curr_snap.State;
 
-                curr_pass.AcquireBufferBarriers.push_back(acquire);
+                curr_pass.Sync.AcquireBufferBarriers.push_back(acquire);
             }
             else
             {
@@ -482,12 +958,159 @@ void RenderGraph::ConstructSynchronizationStructures()
                 }
 
                 Barrier barrier;
-                barrier.Resource = lifetime.Name;
+                barrier.Resource = lifetime.Index;
                 barrier.Source = prev_snap.State;
                 barrier.Destination = curr_snap.State;
 
-                curr_pass.BufferBarriers.push_back(barrier);
+                if (is_split(prev_snap.PassIndex, curr_snap.PassIndex))
+                {
+                    get_split(curr_pass, prev_snap.PassIndex)->BufferBarriers.push_back(barrier);
+                }
+                else
+                {
+                    curr_pass.Sync.BufferBarriers.push_back(barrier);
+                }
             }
         }
     } // End iterate buffer lifetimes
-}
\ No newline at end of file
+
+    // Every barrier between two passes is known, the source pass sets the same events
+    for (auto& pass : m_Passes)
+    {
+        for (SplitBarrier& split : pass.Sync.WaitSplitBarriers)
+        {
+            for (uint32 i = 0; i < AR_FRAME_COUNT; i++)
+            {
+                split.Events[i] = m_GraphDevice->CreateBarrierEvent();
+            }
+            m_Passes[split.SourcePass].Sync.SignalSplitBarriers.push_back(split);
+        }
+    }
+}
+void RenderGraph::ConstructTransientTextures()
+{
+    AR_PROFILE_FUNCTION();
+
+    // Lifetimes are ranges of the execution order
+    std::vector<uint32> positions = GetExecutionPositions();
+
+    // Created textures that are used, imported ones are owned elsewhere
+    std::vector<RenderGraphTransientTexture> textures;
+    for (uint32 index = 0; index < m_TextureLifetimes.size(); index++)
+    {
+        RenderGraphResourceLifetime& lifetime = m_TextureLifetimes[index];
+        if (lifetime.Lifetime.empty() || m_Registry.IsTextureImported(index))
+        {
+            continue;
+        }
+
+        RenderGraphResourceLifetime::Snapshot& first_snap = lifetime.Lifetime.front();
+        RenderGraphResourceLifetime::Snapshot& last_snap = lifetime.Lifetime.back();
+        textures.push_back({index, positions[first_snap.PassIndex], positions[last_snap.PassIndex], first_snap.Queue, last_snap.Queue});
+    }
+
+    std::vector<RenderGraphTextureAlias> aliases = m_TransientAllocator.Plan(textures, &m_Registry);
+    for (RenderGraphTextureAlias& alias : aliases)
+    {
+        RenderGraphResourceLifetime& previous = m_TextureLifetimes[alias.Previous];
+        RenderGraphResourceLifetime& next = m_TextureLifetimes[alias.Next];
+        ResourceState previous_state = previous.Lifetime.back().State;
+
+        RenderGraphPass& pass = m_Passes[next.Lifetime.front().PassIndex];
+        auto is_next = [&alias](const Barrier& barrier) { return barrier.Resource == alias.Next; };
+
+        auto aliasing = std::find_if(pass.Sync.AliasingBarriers.begin(), pass.Sync.AliasingBarriers.end(), is_next);
+        if (aliasing != pass.Sync.AliasingBarriers.end())
+        {
+            // Several textures used parts of the memory, wait for all of them
+            aliasing->Source.Bind |= previous_state.Bind;
+            aliasing->Source.Stage |= previous_state.Stage;
+            continue;
+        }
+
+        // Replaces the initial barrier, the first one of the texture in its first pass
+        auto initial = std::find_if(pass.Sync.TextureBarriers.begin(), pass.Sync.TextureBarriers.end(), is_next);
+        if (initial != pass.Sync.TextureBarriers.end())
+        {
+            pass.Sync.TextureBarriers.erase(initial);
+        }
+
+        Barrier barrier;
+        barrier.Resource = alias.Next;
+        barrier.Source = previous_state;
+        barrier.Destination = next.Lifetime.front().State;
+        pass.Sync.AliasingBarriers.push_back(barrier);
+    }
+}
+
+void RenderGraph::DestroyCompiledSync()
+{
+    for (auto& sync : m_CompiledSync)
+    {
+        for (auto& sem : sync.SignalSemaphores)
+        {
+            m_GraphDevice->ReleaseSemaphore(sem);
+        }
+        for (auto& split : sync.WaitSplitBarriers)
+        {
+            for (VkEvent event : split.Events)
+            {
+                m_GraphDevice->DestroyBarrierEvent(event);
+            }
+        }
+    }
+    m_CompiledSync.clear();
+    m_CompiledCulled.clear();
+    m_CompiledDependencies.clear();
+    m_ExecutionOrder.clear();
+    m_CompiledStructureHash = 0;
+}
+
+std::vector<uint32> RenderGraph::GetExecutionPositions() const
+{
+    std::vector<uint32> positions(m_Passes.size(), 0);
+    for (uint32 i = 0; i < m_ExecutionOrder.size(); i++)
+    {
+        positions[m_ExecutionOrder[i]] = i;
+    }
+    return positions;
+}
+
+uint64 RenderGraph::HashPassStructure(const RenderGraphBuilderPass& pass)
+{
+    Hasher hasher;
+    hasher.u32((uint32)pass.Queue);
+    hasher.u32((uint32)pass.Type);
+
+    auto hash_snapshots = [&hasher](const std::vector<RenderGraphResourceSnapshot>& snapshots) {
+        hasher.u32(snapshots.size());
+        for (const RenderGraphResourceSnapshot& snap : snapshots)
+        {
+            hasher.u32(snap.Index);
+            hasher.u32((uint32)snap.State.Bind);
+            hasher.u32((uint32)snap.State.Stage);
+        }
+    };
+
+    // Creation order determines resource indices, so creates and imports are part of the structure too
+    hash_snapshots(pass.TextureCreatesAndImports);
+    hash_snapshots(pass.BufferCreatesAndImports);
+    hash_snapshots(pass.TextureReads);
+    hash_snapshots(pass.TextureWrites);
+    hash_snapshots(pass.TextureReadWrites);
+    hash_snapshots(pass.BufferReads);
+    hash_snapshots(pass.BufferWrites);
+    hash_snapshots(pass.BufferReadWrites);
+
+    auto hash_indices = [&hasher](const std::vector<uint32>& indices) {
+        hasher.u32(indices.size());
+        for (uint32 index : indices)
+        {
+            hasher.u32(index);
+        }
+    };
+    hash_indices(pass.TextureOutputs);
+    hash_indices(pass.BufferOutputs);
+
+    return hasher.GetHash();
+}
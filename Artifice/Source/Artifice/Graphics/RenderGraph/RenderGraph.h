@@ -4,43 +4,61 @@
 #include <vector>
 #include <unordered_map>
 #include <map>
+#include <set>
 #include <functional>
 
 #include <vulkan/vulkan.h>
 
 #include "Artifice/Core/Core.h"
 #include "Artifice/Core/Variant.h"
+#include "Artifice/Core/JobSystem.h"
 #include "Artifice/Graphics/Resources.h"
+#include "Artifice/Utils/Hash.h"
 
 #include "Artifice/Graphics/Device.h"
 
 #include "RenderGraphBuilder.h"
 #include "RenderGraphRegistry.h"
+#include "RenderGraphTransientAllocator.h"
+#include "RenderGraphDevice.h"
 
 #define RENDER_GRAPH_PRIMARY_SWAPCHAIN_NAME "Primary Swapchain"
 
+class RenderGraphSubgraph;
 
+
+// Resources are texture or buffer indices of the registry
 struct Barrier
 {
-    std::string Resource;
+    uint32 Resource;
     ResourceState Source;
     ResourceState Destination;
 };
 struct ReleaseBarrier
 {
-    std::string Resource;
+    uint32 Resource;
     ResourceState Source;
     ResourceState Destination;
     QueueType DestinationQueue;
 };
 struct AcquireBarrier
 {
-    std::string Resource;
+    uint32 Resource;
     ResourceState Source;
     ResourceState Destination;
     QueueType SourceQueue;
 };
 
+// Barriers between two passes on the same queue with other passes in between. The event is set after the source
+// pass and waited on before this one, so the passes in between don't wait. One event per frame in flight.
+struct SplitBarrier
+{
+    uint32 SourcePass;
+    VkEvent Events[AR_FRAME_COUNT];
+    std::vector<Barrier> TextureBarriers;
+    std::vector<Barrier> BufferBarriers;
+};
+
 enum class RenderGraphResourceAccess
 {
     Read, Write, ReadWrite
@@ -55,13 +73,37 @@ struct RenderGraphResourceLifetime
         QueueType Queue;
         uint32 PassIndex;
     };
-    std::string Name;
+    uint32 Index;
     ResourceState InitialState;
     std::vector<Snapshot> Lifetime; 
 };
 
 // RENDER GRAPH PASS
 
+// Barriers and semaphores of a pass. These only depend on the structure of the graph, so they are reused between
+// frames while its structure hash is unchanged.
+struct RenderGraphPassSynchronization
+{
+    std::vector<VkSemaphore> WaitSemaphores;
+    std::vector<PipelineStageFlags> WaitStages;
+    std::vector<VkSemaphore> SignalSemaphores;
+
+    // Transient textures taking over memory from textures used before, replace their initial barrier
+    std::vector<Barrier> AliasingBarriers;
+    std::vector<Barrier> TextureBarriers;
+    std::vector<Barrier> BufferBarriers;
+    std::vector<ReleaseBarrier> ReleaseTextureBarriers;
+    std::vector<ReleaseBarrier> ReleaseBufferBarriers;
+    std::vector<AcquireBarrier> AcquireTextureBarriers;
+    std::vector<AcquireBarrier> AcquireBufferBarriers;
+    // Waited on before the pass, the events are owned by these
+    std::vector<SplitBarrier> WaitSplitBarriers;
+    // Set after the pass, copies of the wait side of later passes
+    std::vector<SplitBarrier> SignalSplitBarriers;
+
+    void Clear();
+};
+
 struct RenderGraphPass
 {
     using EvaluationFunction = std::function<void(RenderGraphRegistry*, CommandBuffer*)>;
@@ -73,24 +115,27 @@ struct RenderGraphPass
 
     RenderPassInfo RenderPassInfo;
 
+    // Passes that have to execute before this one, indices into the passes of the graph
     std::set<uint32> PassDependencies;
 
-    std::vector<VkSemaphore> WaitSemaphores;
-    std::vector<PipelineStageFlags> WaitStages;
-    std::vector<VkSemaphore> SignalSemaphores;
-
-    std::vector<Barrier> TextureBarriers;
-    std::vector<Barrier> BufferBarriers;
-    std::vector<ReleaseBarrier> ReleaseTextureBarriers;
-    std::vector<ReleaseBarrier> ReleaseBufferBarriers;
-    std::vector<AcquireBarrier> AcquireTextureBarriers;
-    std::vector<AcquireBarrier> AcquireBufferBarriers;
+    // Hash of the queue, type and declared resource accesses, see RenderGraph::Compile
+    uint64 StructureHash = 0;
+    RenderGraphPassSynchronization Sync;
+    // None of the resources it writes are used, so it is not evaluated
+    bool Culled = false;
 
     EvaluationFunction Evaluate;
 
+    // Resolved by Prepare, so Record doesn't touch the caches
+    RenderHandle PreparedRenderPass;
+    RenderHandle PreparedFramebuffer;
+    std::vector<VkClearValue> PreparedClearValues;
+
 
-    void ClearSynchronizationStructures();
-    void EvaluateInternal(RenderGraphRenderPassCache* render_pass_cache, RenderGraphFramebufferCache* framebuffer_cache, RenderGraphRegistry* registry, CommandBuffer* cmd, Device* device);
+    // Creates the resources, render pass and framebuffer of the pass, the caches are not thread safe
+    void Prepare(RenderGraphRenderPassCache* render_pass_cache, RenderGraphFramebufferCache* framebuffer_cache, RenderGraphRegistry* registry, Device* device);
+    // Records the barriers and the pass, on a worker thread if the pass is parallel
+    void Record(RenderGraphRegistry* registry, CommandBuffer* cmd, uint32 frame_index);
 };
 
 
@@ -132,7 +177,12 @@ private:
 class RenderGraph
 {
 private:
-    Device* m_Device;
+    // Null for headless graphs, which can only be compiled
+    Device* m_Device = nullptr;
+    RenderGraphDeviceAdapter m_DeviceAdapter;
+    RenderGraphDevice* m_GraphDevice = nullptr;
+    // Records parallel passes when set, otherwise every pass is recorded on the calling thread
+    JobSystem* m_JobSystem = nullptr;
     Blackboard m_Blackboard;
     RenderGraphRegistry m_Registry;
     RenderGraphRenderPassCache m_RenderPassCache;
@@ -142,14 +192,35 @@ private:
     std::vector<RenderGraphResourceLifetime> m_TextureLifetimes;
     std::vector<RenderGraphResourceLifetime> m_BufferLifetimes;
 
+    // Hash of every pass structure added since the last reset
+    uint64 m_StructureHash = FNV_OFFSET_BASIS_64;
+    // Structure and per pass synchronization of the last compile from scratch, owns the semaphores
+    uint64 m_CompiledStructureHash = 0;
+    std::vector<RenderGraphPassSynchronization> m_CompiledSync;
+    std::vector<bool> m_CompiledCulled;
+    std::vector<std::set<uint32>> m_CompiledDependencies;
+    // Indices of the passes that are not culled, in the order they are recorded and submitted
+    std::vector<uint32> m_ExecutionOrder;
+
+    // Memory of the created textures, planned with the synchronization
+    RenderGraphTransientAllocator m_TransientAllocator;
+
+    // Subgraphs read by the passes since the last reset, they submit separately before the graph
+    std::vector<RenderGraphSubgraph*> m_Subgraphs;
+    bool m_SubgraphsEvaluated = false;
+
 public:
     RenderGraph() = default;
     RenderGraph(Device* device);
 
     void Init(Device* device);
+    // Without a Device, for compiling graphs without a GPU. Evaluate can't be called.
+    void InitHeadless(RenderGraphDevice* graph_device);
 
     void CleanUp();
 
+    void SetJobSystem(JobSystem* job_system) { m_JobSystem = job_system; }
+
     void Reset();
 
     void WriteBlackboard(std::string key, Variant value)
@@ -166,16 +237,29 @@ public:
 
     void Compile();
 
+    // Evaluates the subgraphs that are due, once per evaluation. Evaluate calls it when it hasn't been called yet, call it
+    // earlier when the first submit of the graph has to take queue semaphores that were added before evaluating.
+    void EvaluateSubgraphs();
+
     void Evaluate();
 
 private:
+    void CullPasses();
+    void SchedulePasses();
     void ConstructResourceLifetimes();
     void ConstructSynchronizationStructures();
+    void ConstructTransientTextures();
+    void DestroyCompiledSync();
+    // Position of every pass in the execution order, culled passes are at 0
+    std::vector<uint32> GetExecutionPositions() const;
+
+    static uint64 HashPassStructure(const RenderGraphBuilderPass& pass);
 
 public:
     struct Statistics
     {
         uint32 TotalPassCount = 0;
+        uint32 CulledPassCount = 0;
         uint32 RenderPassCount = 0;
         uint32 TextureCount = 0;
         uint32 BufferCount = 0;
@@ -189,6 +273,16 @@ public:
 
         std::vector<std::string> PassNames;
         std::vector<float> PassTimes;
+
+        // Whether Compile reused the synchronization of the previous frame
+        bool CompileCached = false;
+        // Transient texture heaps, and the memory the same textures take without aliasing
+        uint64 TransientMemory = 0;
+        uint64 TransientMemoryUnaliased = 0;
+        // Synchronization of the compiled graph, split barriers are counted in BarrierCount too
+        uint32 BarrierCount = 0;
+        uint32 SplitBarrierCount = 0;
+        uint32 SemaphoreCount = 0;
     };
 
     Statistics GetStats() const { return m_Statistics; }
@@ -8,6 +8,9 @@
 #include "Artifice/math/vec4.h"
 
 #include "RenderGraphRegistry.h"
+#include "RenderGraphDevice.h"
+
+class RenderGraphSubgraph;
 
 enum class RenderGraphPassType
 {
@@ -15,12 +18,20 @@ enum class RenderGraphPassType
     Other
 };
 
+// Access of a pass to a resource, the index is into the textures or buffers of the registry
 struct RenderGraphResourceSnapshot
 {
-    std::string Name;
+    uint32 Index;
     ResourceState State;
 };
 
+// Subgraph whose output a pass reads, and the queue the output was handed to
+struct RenderGraphSubgraphUse
+{
+    RenderGraphSubgraph* Subgraph;
+    QueueType Queue;
+};
+
 struct RenderGraphBuilderPass
 {
     QueueType Queue = QueueType::Universal;
@@ -36,49 +47,62 @@ struct RenderGraphBuilderPass
     std::vector<RenderGraphResourceSnapshot> TextureCreatesAndImports;
     std::vector<RenderGraphResourceSnapshot> BufferCreatesAndImports;
 
-    std::vector<std::string> ColorAttachments;
+    // Resources used outside the graph, keep the passes writing them alive
+    std::vector<uint32> TextureOutputs;
+    std::vector<uint32> BufferOutputs;
+
+    // Texture indices
+    std::vector<uint32> ColorAttachments;
     std::vector<vec4> ColorClearColors;
     std::vector<int32> ColorLayers;
-    std::vector<std::string> DepthAttachment;
-    std::vector<std::string> ResolveAttachments;
+    std::vector<uint32> DepthAttachment;
+    std::vector<uint32> ResolveAttachments;
+
+    // Evaluation function may record on a worker thread, see RenderGraphBuilder::SetParallel
+    bool Parallel = false;
 
-    void AddTextureRead(const std::string& name, ResourceState state)
+    // Subgraphs whose outputs the pass reads, evaluated before the graph when due
+    std::vector<RenderGraphSubgraphUse> Subgraphs;
+
+    void AddTextureRead(RenderGraphTextureHandle texture, ResourceState state)
     {
-        TextureReads.push_back({name, state});
+        TextureReads.push_back({texture.Index, state});
     }
-    void AddTextureWrite(const std::string& name, ResourceState state)
+    void AddTextureWrite(RenderGraphTextureHandle texture, ResourceState state)
     {
-        TextureWrites.push_back({name, state});
+        TextureWrites.push_back({texture.Index, state});
     }
-    void AddTextureReadWrite(const std::string& name, ResourceState state)
+    void AddTextureReadWrite(RenderGraphTextureHandle texture, ResourceState state)
     {
-        TextureReadWrites.push_back({name, state});
+        TextureReadWrites.push_back({texture.Index, state});
     }
-    void AddBufferRead(const std::string& name, ResourceState state)
+    void AddBufferRead(RenderGraphBufferHandle buffer, ResourceState state)
     {
-        BufferReads.push_back({name, state});
+        BufferReads.push_back({buffer.Index, state});
     }
-    void AddBufferWrite(const std::string& name, ResourceState state)
+    void AddBufferWrite(RenderGraphBufferHandle buffer, ResourceState state)
     {
-        BufferWrites.push_back({name, state});
+        BufferWrites.push_back({buffer.Index, state});
     }
-    void AddBufferReadWrite(const std::string& name, ResourceState state)
+    void AddBufferReadWrite(RenderGraphBufferHandle buffer, ResourceState state)
     {
-        BufferReadWrites.push_back({name, state});
+        BufferReadWrites.push_back({buffer.Index, state});
     }
 };
 
+// Resources can be passed by name or by the handle returned when creating them. Evaluation functions should capture
+// handles, name lookups hash the string every time.
 class RenderGraphBuilder
 {
 private:
-    Device* m_Device;
+    RenderGraphDevice* m_Device;
     RenderGraphRegistry* m_Registry;
     RenderGraphBuilderPass m_Pass;
     RenderPassInfo m_RenderPassInfo;
 
 public:
     RenderGraphBuilder() = default;
-    RenderGraphBuilder(Device* device, RenderGraphRegistry* registry) : m_Device(device), m_Registry(registry) {}
+    RenderGraphBuilder(RenderGraphDevice* device, RenderGraphRegistry* registry) : m_Device(device), m_Registry(registry) {}
     RenderGraphBuilderPass GetPass() const { return m_Pass; }
     RenderPassInfo GetRenderPassInfo() const { return m_RenderPassInfo; }
 
@@ -91,134 +115,204 @@ public:
     {
         m_Pass.Queue = queue;
     }
+    // Records the pass on a worker thread, together with the parallel passes around it. The evaluation function may
+    // only read the registry and request scratch buffers and descriptor sets from the device.
+    void SetParallel(bool parallel = true)
+    {
+        m_Pass.Parallel = parallel;
+    }
+
+    // Called by RenderGraphSubgraph::Import
+    void UseSubgraph(RenderGraphSubgraph* subgraph, QueueType queue)
+    {
+        m_Pass.Subgraphs.push_back({subgraph, queue});
+    }
 
     bool Exists(const std::string& name)
     {
         return m_Registry->Exists(name);
     }
+    RenderGraphTextureHandle GetTextureHandle(const std::string& name) const
+    {
+        return m_Registry->GetTextureHandle(name);
+    }
+    RenderGraphBufferHandle GetBufferHandle(const std::string& name) const
+    {
+        return m_Registry->GetBufferHandle(name);
+    }
     TextureInfo GetTextureInfo(const std::string& name) const
     {
         return m_Registry->GetTextureInfo(name);
     }
+    TextureInfo GetTextureInfo(RenderGraphTextureHandle texture) const
+    {
+        return m_Registry->GetTextureInfo(texture);
+    }
     
-    void CreateTexture(const std::string& name, TextureInfo info)
+    RenderGraphTextureHandle CreateTexture(const std::string& name, TextureInfo info)
     {
-        m_Registry->CreateTexture(name, info);
-        m_Pass.TextureCreatesAndImports.push_back({name, ResourceState::None()});
+        RenderGraphTextureHandle texture = m_Registry->CreateTexture(name, info);
+        m_Pass.TextureCreatesAndImports.push_back({texture.Index, ResourceState::None()});
+        return texture;
     }
-    void ImportTexture(const std::string& name, RenderHandle texture, ResourceState previous_state = ResourceState::None())
+    RenderGraphTextureHandle ImportTexture(const std::string& name, RenderHandle texture, ResourceState previous_state = ResourceState::None())
     {
-        m_Registry->ImportTexture(name, texture, m_Device->GetTextureInfo(texture));
-        m_Pass.TextureCreatesAndImports.push_back({name, previous_state});
+        RenderGraphTextureHandle handle = m_Registry->ImportTexture(name, texture, m_Device->GetTextureInfo(texture));
+        m_Pass.TextureCreatesAndImports.push_back({handle.Index, previous_state});
+        return handle;
     }
-    void CreateBuffer(const std::string& name, BufferInfo info)
+    RenderGraphBufferHandle CreateBuffer(const std::string& name, BufferInfo info)
     {
-        m_Registry->CreateBuffer(name, info);
-        m_Pass.BufferCreatesAndImports.push_back({name, ResourceState::None()});
+        RenderGraphBufferHandle buffer = m_Registry->CreateBuffer(name, info);
+        m_Pass.BufferCreatesAndImports.push_back({buffer.Index, ResourceState::None()});
+        return buffer;
     }
-    void ReadTexture(const std::string& name, ResourceState state)
+    void ReadTexture(RenderGraphTextureHandle texture, ResourceState state)
     {
-        m_Pass.AddTextureRead(name, state);
-        m_Registry->AddTextureBindFlag(name, state.Bind);
+        m_Pass.AddTextureRead(texture, state);
+        m_Registry->AddTextureBindFlag(texture, state.Bind);
         
         if (state == ResourceState::Color())
         {
-            TextureInfo info = m_Registry->GetTextureInfo(name);
+            TextureInfo info = m_Registry->GetTextureInfo(texture);
             uint32 index = m_RenderPassInfo.Layout.ColorCount++;
             m_RenderPassInfo.Layout.Colors[index] = {info.Format, info.Samples};
             m_RenderPassInfo.ColorOptions[index] = {LoadOptions::Load, StoreOptions::Store};
-            m_Pass.ColorAttachments.push_back(name);
+            m_Pass.ColorAttachments.push_back(texture.Index);
             m_Pass.ColorClearColors.push_back({0.0f, 0.0f, 0.0f, 1.0f});
         }
         else if (state == ResourceState::Depth())
         {
-            TextureInfo info = m_Registry->GetTextureInfo(name);
+            TextureInfo info = m_Registry->GetTextureInfo(texture);
             uint32 index = m_RenderPassInfo.Layout.DepthCount++;
             m_RenderPassInfo.Layout.Depth[index] = {info.Format, info.Samples};
             m_RenderPassInfo.DepthOptions[index] = {LoadOptions::Load, StoreOptions::Store};
-            m_Pass.DepthAttachment.push_back(name);
+            m_Pass.DepthAttachment.push_back(texture.Index);
         }
         else if (state == ResourceState::Resolve())
         {
             uint32 index = m_RenderPassInfo.Layout.ResolveCount++;
             m_RenderPassInfo.ResolveOptions[index] = {LoadOptions::Load, StoreOptions::Store};
-            m_Pass.ResolveAttachments.push_back(name);
+            m_Pass.ResolveAttachments.push_back(texture.Index);
         }
     }
-    void WriteTexture(const std::string& name, ResourceState state, bool clear = false, vec4 clear_color = {0.0f, 0.0f, 0.0f, 1.0f}, int32 layer = -1)
+    void WriteTexture(RenderGraphTextureHandle texture, ResourceState state, bool clear = false, vec4 clear_color = {0.0f, 0.0f, 0.0f, 1.0f}, int32 layer = -1)
     {
-        m_Pass.AddTextureWrite(name, state);
-        m_Registry->AddTextureBindFlag(name, state.Bind);
+        m_Pass.AddTextureWrite(texture, state);
+        m_Registry->AddTextureBindFlag(texture, state.Bind);
 
         if (state == ResourceState::Color())
         {
-            TextureInfo info = m_Registry->GetTextureInfo(name);
+            TextureInfo info = m_Registry->GetTextureInfo(texture);
             uint32 index = m_RenderPassInfo.Layout.ColorCount++;
             m_RenderPassInfo.Layout.Colors[index] = {info.Format, info.Samples};
             m_RenderPassInfo.ColorOptions[index] = {clear ? LoadOptions::Clear : LoadOptions::Discard, StoreOptions::Store};
-            m_Pass.ColorAttachments.push_back(name);
+            m_Pass.ColorAttachments.push_back(texture.Index);
             m_Pass.ColorClearColors.push_back(clear_color);
             m_Pass.ColorLayers.push_back(layer);
 
         }
         else if (state == ResourceState::Depth())
         {
-            TextureInfo info = m_Registry->GetTextureInfo(name);
+            TextureInfo info = m_Registry->GetTextureInfo(texture);
             uint32 index = m_RenderPassInfo.Layout.DepthCount++;
             m_RenderPassInfo.Layout.Depth[index] = {info.Format, info.Samples};
             m_RenderPassInfo.DepthOptions[index] = {clear ? LoadOptions::Clear : LoadOptions::Discard, StoreOptions::Store};
-            m_Pass.DepthAttachment.push_back(name);
+            m_Pass.DepthAttachment.push_back(texture.Index);
         }
         else if (state == ResourceState::Resolve())
         {
             uint32 index = m_RenderPassInfo.Layout.ResolveCount++;
             m_RenderPassInfo.ResolveOptions[index] = {LoadOptions::Discard, StoreOptions::Store};
-            m_Pass.ResolveAttachments.push_back(name);
+            m_Pass.ResolveAttachments.push_back(texture.Index);
         }
     }
-    void ReadWriteTexture(const std::string& name, ResourceState state, int32 layer = -1)
+    void ReadWriteTexture(RenderGraphTextureHandle texture, ResourceState state, int32 layer = -1)
     {
-        m_Pass.AddTextureReadWrite(name, state);
-        m_Registry->AddTextureBindFlag(name, state.Bind);
+        m_Pass.AddTextureReadWrite(texture, state);
+        m_Registry->AddTextureBindFlag(texture, state.Bind);
 
         if (state == ResourceState::Color())
         {
-            TextureInfo info = m_Registry->GetTextureInfo(name);
+            TextureInfo info = m_Registry->GetTextureInfo(texture);
             uint32 index = m_RenderPassInfo.Layout.ColorCount++;
             m_RenderPassInfo.Layout.Colors[index] = {info.Format, info.Samples};
             m_RenderPassInfo.ColorOptions[index] = {LoadOptions::Load, StoreOptions::Store};
-            m_Pass.ColorAttachments.push_back(name);
+            m_Pass.ColorAttachments.push_back(texture.Index);
             m_Pass.ColorClearColors.push_back({0.0f, 0.0f, 0.0f, 1.0f});
             m_Pass.ColorLayers.push_back(layer);
         }
         else if (state == ResourceState::Depth())
         {
-            TextureInfo info = m_Registry->GetTextureInfo(name);
+            TextureInfo info = m_Registry->GetTextureInfo(texture);
             uint32 index = m_RenderPassInfo.Layout.DepthCount++;
             m_RenderPassInfo.Layout.Depth[index] = {info.Format, info.Samples};
             m_RenderPassInfo.DepthOptions[index] = {LoadOptions::Load, StoreOptions::Store};
-            m_Pass.DepthAttachment.push_back(name);
+            m_Pass.DepthAttachment.push_back(texture.Index);
         }
         else if (state == ResourceState::Resolve())
         {
             uint32 index = m_RenderPassInfo.Layout.ResolveCount++;
             m_RenderPassInfo.ResolveOptions[index] = {LoadOptions::Load, StoreOptions::Store};
-            m_Pass.ResolveAttachments.push_back(name);
+            m_Pass.ResolveAttachments.push_back(texture.Index);
         }
     }
+    void ReadTexture(const std::string& name, ResourceState state)
+    {
+        ReadTexture(GetTextureHandle(name), state);
+    }
+    void WriteTexture(const std::string& name, ResourceState state, bool clear = false, vec4 clear_color = {0.0f, 0.0f, 0.0f, 1.0f}, int32 layer = -1)
+    {
+        WriteTexture(GetTextureHandle(name), state, clear, clear_color, layer);
+    }
+    void ReadWriteTexture(const std::string& name, ResourceState state, int32 layer = -1)
+    {
+        ReadWriteTexture(GetTextureHandle(name), state, layer);
+    }
+    // Keeps the passes writing the resource from being culled, imported textures always are
+    void MarkTextureOutput(RenderGraphTextureHandle texture)
+    {
+        m_Pass.TextureOutputs.push_back(texture.Index);
+    }
+    void MarkBufferOutput(RenderGraphBufferHandle buffer)
+    {
+        m_Pass.BufferOutputs.push_back(buffer.Index);
+    }
+    void MarkTextureOutput(const std::string& name)
+    {
+        AR_CORE_ASSERT(m_Registry->Exists(name), "Tried marking texture that doesn't exist as output");
+        MarkTextureOutput(GetTextureHandle(name));
+    }
+    void MarkBufferOutput(const std::string& name)
+    {
+        AR_CORE_ASSERT(m_Registry->Exists(name), "Tried marking buffer that doesn't exist as output");
+        MarkBufferOutput(GetBufferHandle(name));
+    }
+    void ReadBuffer(RenderGraphBufferHandle buffer, ResourceState state)
+    {
+        m_Pass.AddBufferRead(buffer, state);
+        m_Registry->AddBufferBindFlag(buffer, state.Bind);
+    }
+    void WriteBuffer(RenderGraphBufferHandle buffer, ResourceState state)
+    {
+        m_Pass.AddBufferWrite(buffer, state);
+        m_Registry->AddBufferBindFlag(buffer, state.Bind);
+    }
+    void ReadWriteBuffer(RenderGraphBufferHandle buffer, ResourceState state)
+    {
+        m_Pass.AddBufferReadWrite(buffer, state);
+        m_Registry->AddBufferBindFlag(buffer, state.Bind);
+    }
     void ReadBuffer(const std::string& name, ResourceState state)
     {
-        m_Pass.AddBufferRead(name, state);
-        m_Registry->AddBufferBindFlag(name, state.Bind);
+        ReadBuffer(GetBufferHandle(name), state);
     }
     void WriteBuffer(const std::string& name, ResourceState state)
     {
-        m_Pass.AddBufferWrite(name, state);
-        m_Registry->AddBufferBindFlag(name, state.Bind);
+        WriteBuffer(GetBufferHandle(name), state);
     }
     void ReadWriteBuffer(const std::string& name, ResourceState state)
     {
-        m_Pass.AddBufferReadWrite(name, state);
-        m_Registry->AddBufferBindFlag(name, state.Bind);
+        ReadWriteBuffer(GetBufferHandle(name), state);
     }
 };
\ No newline at end of file
@@ -0,0 +1,34 @@
+#include "RenderGraphDevice.h"
+
+#include "Artifice/Graphics/Device.h"
+
+
+TextureInfo RenderGraphDeviceAdapter::GetTextureInfo(RenderHandle texture)
+{
+    return m_Device->GetTextureInfo(texture);
+}
+
+MemoryRequirements RenderGraphDeviceAdapter::GetTextureMemoryRequirements(const TextureInfo& info)
+{
+    return m_Device->GetTextureMemoryRequirements(info);
+}
+
+VkSemaphore RenderGraphDeviceAdapter::RequestSemaphore()
+{
+    return m_Device->RequestSemaphore();
+}
+
+void RenderGraphDeviceAdapter::ReleaseSemaphore(VkSemaphore semaphore)
+{
+    m_Device->ReleaseSemaphore(semaphore);
+}
+
+VkEvent RenderGraphDeviceAdapter::CreateBarrierEvent()
+{
+    return m_Device->CreateBarrierEvent();
+}
+
+void RenderGraphDeviceAdapter::DestroyBarrierEvent(VkEvent event)
+{
+    m_Device->DestroyBarrierEvent(event);
+}
@@ -0,0 +1,47 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+
+#include "Artifice/Core/Core.h"
+#include "Artifice/Graphics/Resources.h"
+#include "Artifice/Graphics/RenderHandle.h"
+
+class Device;
+
+// What building and compiling a graph needs from the device. Evaluating it still needs the Device, but with only
+// this a graph can be built and compiled without a GPU, see RenderGraph::InitHeadless.
+class RenderGraphDevice
+{
+public:
+    virtual ~RenderGraphDevice() = default;
+
+    // Info of an imported texture
+    virtual TextureInfo GetTextureInfo(RenderHandle texture) = 0;
+    // Size and alignment of a transient texture, for placing it in a heap
+    virtual MemoryRequirements GetTextureMemoryRequirements(const TextureInfo& info) = 0;
+
+    // Owned by the compiled synchronization, returned when the graph structure changes
+    virtual VkSemaphore RequestSemaphore() = 0;
+    virtual void ReleaseSemaphore(VkSemaphore semaphore) = 0;
+    virtual VkEvent CreateBarrierEvent() = 0;
+    virtual void DestroyBarrierEvent(VkEvent event) = 0;
+};
+
+// Forwards to the device
+class RenderGraphDeviceAdapter : public RenderGraphDevice
+{
+private:
+    Device* m_Device = nullptr;
+
+public:
+    RenderGraphDeviceAdapter() = default;
+    RenderGraphDeviceAdapter(Device* device) : m_Device(device) {}
+
+    TextureInfo GetTextureInfo(RenderHandle texture) override;
+    MemoryRequirements GetTextureMemoryRequirements(const TextureInfo& info) override;
+
+    VkSemaphore RequestSemaphore() override;
+    void ReleaseSemaphore(VkSemaphore semaphore) override;
+    VkEvent CreateBarrierEvent() override;
+    void DestroyBarrierEvent(VkEvent event) override;
+};
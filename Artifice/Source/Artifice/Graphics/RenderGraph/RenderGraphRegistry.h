@@ -9,18 +9,48 @@
 #include "RenderGraphResourceCache.h"
 
 
+// Resource of the graph being built, the index of the resource in the registry and the build it was created in.
+// Only valid until the graph is reset.
+template <class Tag>
+struct RenderGraphResourceHandle
+{
+    uint32 Index = UINT32_MAX;
+    uint32 Version = 0;
+
+    bool IsNull() const { return Index == UINT32_MAX; }
+
+    bool operator==(const RenderGraphResourceHandle& other) const
+    {
+        return Index == other.Index && Version == other.Version;
+    }
+    bool operator!=(const RenderGraphResourceHandle& other) const
+    {
+        return !(*this == other);
+    }
+};
+using RenderGraphTextureHandle = RenderGraphResourceHandle<struct RenderGraphTextureTag>;
+using RenderGraphBufferHandle = RenderGraphResourceHandle<struct RenderGraphBufferTag>;
+
+
 class RenderGraphRegistry
 {
 private:
     RenderGraphTextureCache m_TextureCache;
     RenderGraphBufferCache m_BufferCache;
-    
+
+    // Names are only looked up by the name based functions, the graph itself uses indices
     std::unordered_map<std::string, uint32> m_ResourceMap;
     std::vector<TextureInfo> m_Textures;
     std::vector<BufferInfo> m_Buffers;
+    std::vector<std::string> m_TextureNames;
+    std::vector<std::string> m_BufferNames;
 
     std::vector<RenderHandle> m_TextureHandles;
     std::vector<RenderHandle> m_BufferHandles;
+    std::vector<bool> m_TextureImports;
+
+    // Incremented on every clear, so handles of previous builds are caught
+    uint32 m_Version = 1;
 
 public:
     RenderGraphRegistry() = default;
@@ -33,7 +63,7 @@ public:
     {
         m_TextureCache.ReleaseActive();
         m_BufferCache.ReleaseActive();
-        
+
         m_TextureCache.Advance();
         m_BufferCache.Advance();
     }
@@ -43,8 +73,12 @@ public:
         m_ResourceMap.clear();
         m_TextureHandles.clear();
         m_BufferHandles.clear();
+        m_TextureImports.clear();
         m_Textures.clear();
         m_Buffers.clear();
+        m_TextureNames.clear();
+        m_BufferNames.clear();
+        m_Version++;
     }
     void CleanUp()
     {
@@ -70,23 +104,48 @@ public:
         return {m_TextureCache.GetAlive(), m_BufferCache.GetAlive()};
     }
 
-    uint32 GetIndex(const std::string& name)
+    uint32 GetIndex(const std::string& name) const
     {
         AR_CORE_ASSERT(m_ResourceMap.count(name), "Tried accessing resource that doesn't exists");
 
-        return m_ResourceMap[name];
+        return m_ResourceMap.at(name);
     }
-    TextureInfo GetTextureInfo(const std::string& name)
+    RenderGraphTextureHandle GetTextureHandle(const std::string& name) const
     {
-        AR_CORE_ASSERT(m_ResourceMap.count(name), "Tried accessing resource that doesn't exists");
+        return {GetIndex(name), m_Version};
+    }
+    RenderGraphBufferHandle GetBufferHandle(const std::string& name) const
+    {
+        return {GetIndex(name), m_Version};
+    }
 
+    TextureInfo GetTextureInfo(const std::string& name) const
+    {
         return m_Textures[GetIndex(name)];
     }
+    const TextureInfo& GetTextureInfo(RenderGraphTextureHandle texture) const
+    {
+        return m_Textures[Validate(texture)];
+    }
+    const TextureInfo& GetTextureInfo(uint32 index) const
+    {
+        return m_Textures[index];
+    }
+    const BufferInfo& GetBufferInfo(RenderGraphBufferHandle buffer) const
+    {
+        return m_Buffers[Validate(buffer)];
+    }
+    const std::string& GetTextureName(uint32 index) const { return m_TextureNames[index]; }
+    const std::string& GetBufferName(uint32 index) const { return m_BufferNames[index]; }
+    bool IsTextureImported(uint32 index) const
+    {
+        return m_TextureImports[index];
+    }
 
     uint32 GetTextureCount() const { return m_Textures.size(); }
     uint32 GetBufferCount() const { return m_Buffers.size(); }
 
-    void ImportTexture(const std::string& name, RenderHandle texture, TextureInfo info)
+    RenderGraphTextureHandle ImportTexture(const std::string& name, RenderHandle texture, TextureInfo info)
     {
         AR_CORE_ASSERT(!m_ResourceMap.count(name), "Tried importing texture that already exists");
 
@@ -94,20 +153,28 @@ public:
         m_ResourceMap[name] = index;
 
         m_Textures.push_back(info);
+        m_TextureNames.push_back(name);
         m_TextureHandles.push_back(texture);
+        m_TextureImports.push_back(true);
+
+        return {index, m_Version};
     }
 
-    void CreateTexture(const std::string& name, TextureInfo info)
+    RenderGraphTextureHandle CreateTexture(const std::string& name, TextureInfo info)
     {
         AR_CORE_ASSERT(!m_ResourceMap.count(name), "Tried creating texture that already exists");
-        
+
         uint32 index = m_Textures.size();
         m_ResourceMap[name] = index;
 
         m_Textures.push_back(info);
+        m_TextureNames.push_back(name);
         m_TextureHandles.push_back(RenderHandle());
+        m_TextureImports.push_back(false);
+
+        return {index, m_Version};
     }
-    void CreateBuffer(const std::string& name, BufferInfo info)
+    RenderGraphBufferHandle CreateBuffer(const std::string& name, BufferInfo info)
     {
         AR_CORE_ASSERT(!m_ResourceMap.count(name), "Tried creating buffer that already exists");
 
@@ -115,46 +182,64 @@ public:
         m_ResourceMap[name] = index;
 
         m_Buffers.push_back(info);
+        m_BufferNames.push_back(name);
         m_BufferHandles.push_back(RenderHandle());
+
+        return {index, m_Version};
     }
 
-    void AddTextureBindFlag(const std::string& name, RenderBindFlags bind_flag)
+    void AddTextureBindFlag(RenderGraphTextureHandle texture, RenderBindFlags bind_flag)
+    {
+        m_Textures[Validate(texture)].BindFlags |= bind_flag;
+    }
+    void AddBufferBindFlag(RenderGraphBufferHandle buffer, RenderBindFlags bind_flag)
+    {
+        m_Buffers[Validate(buffer)].BindFlags |= bind_flag;
+    }
+    // Created texture placed by the graph, instead of requesting it from the cache
+    void SetTexture(uint32 index, RenderHandle texture)
+    {
+        AR_CORE_ASSERT(!m_TextureImports[index], "Tried replacing imported texture");
+        m_TextureHandles[index] = texture;
+    }
+    // Actual resource creation. Once a resource was created this only reads, so passes recorded in parallel can
+    // call it for the resources RenderGraphPass::Prepare resolved.
+    RenderHandle GetTexture(RenderGraphTextureHandle texture)
+    {
+        return GetTexture(Validate(texture));
+    }
+    RenderHandle GetBuffer(RenderGraphBufferHandle buffer)
+    {
+        return GetBuffer(Validate(buffer));
+    }
+    RenderHandle GetTexture(const std::string& name)
     {
         AR_CORE_ASSERT(m_ResourceMap.count(name), "Tried getting texture that does not exist");
-        m_Textures[m_ResourceMap[name]].BindFlags |= bind_flag;
 
+        return GetTexture(m_ResourceMap.at(name));
     }
-    void AddBufferBindFlag(const std::string& name, RenderBindFlags bind_flag)
+    RenderHandle GetBuffer(const std::string& name)
     {
         AR_CORE_ASSERT(m_ResourceMap.count(name), "Tried getting buffer that does not exist");
-        m_Buffers[m_ResourceMap[name]].BindFlags |= bind_flag;
 
+        return GetBuffer(m_ResourceMap.at(name));
     }
-    // Actual resource creation
-    RenderHandle GetTexture(const std::string& name)
+    RenderHandle GetTexture(uint32 index)
     {
-        AR_CORE_ASSERT(m_ResourceMap.count(name), "Tried getting texture that does not exist");
-        
-        uint32 index = m_ResourceMap[name];
-
         if (!m_TextureHandles[index].IsNull())
         {
             return m_TextureHandles[index];
         }
-        
+
         TextureInfo key = m_Textures[index];
-        
+
         RenderHandle handle = m_TextureCache.Request(key);
         m_TextureHandles[index] = handle;
 
         return handle;
     }
-    RenderHandle GetBuffer(const std::string& name)
+    RenderHandle GetBuffer(uint32 index)
     {
-        AR_CORE_ASSERT(m_ResourceMap.count(name), "Tried getting buffer that does not exist");
-
-        uint32 index = m_ResourceMap[name];
-
         if (!m_BufferHandles[index].IsNull())
         {
             return m_BufferHandles[index];
@@ -167,4 +252,16 @@ public:
 
         return handle;
     }
-};
\ No newline at end of file
+
+private:
+    uint32 Validate(RenderGraphTextureHandle texture) const
+    {
+        AR_CORE_ASSERT(texture.Version == m_Version && texture.Index < m_Textures.size(), "Tried using texture handle of another graph build");
+        return texture.Index;
+    }
+    uint32 Validate(RenderGraphBufferHandle buffer) const
+    {
+        AR_CORE_ASSERT(buffer.Version == m_Version && buffer.Index < m_Buffers.size(), "Tried using buffer handle of another graph build");
+        return buffer.Index;
+    }
+};
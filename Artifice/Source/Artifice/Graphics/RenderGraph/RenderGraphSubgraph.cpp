@@ -0,0 +1,166 @@
+#include "RenderGraphSubgraph.h"
+
+#include <algorithm>
+
+#include "Artifice/Debug/Instrumentor.h"
+
+
+void RenderGraphSubgraph::Init(Device* device, ConstructionFunction construct, uint32 interval)
+{
+    m_Graph.Init(device);
+    m_Construct = construct;
+    m_Interval = interval;
+    m_FramesSinceEvaluation = 0;
+    m_Dirty = true;
+    m_Built = false;
+    m_Evaluated = false;
+}
+
+void RenderGraphSubgraph::CleanUp()
+{
+    m_Graph.CleanUp();
+    m_Outputs.clear();
+    m_Built = false;
+    m_Evaluated = false;
+}
+
+void RenderGraphSubgraph::AddOutput(const std::string& name, RenderHandle texture, ResourceState state, QueueType queue)
+{
+    m_Outputs.push_back({name, state, queue, texture});
+    Invalidate();
+}
+
+RenderGraphTextureHandle RenderGraphSubgraph::Import(RenderGraphBuilder* builder, const std::string& name)
+{
+    if (!m_Built)
+    {
+        Build();
+    }
+
+    auto output = std::find_if(m_Outputs.begin(), m_Outputs.end(), [&name](const Output& output) {
+        return output.Name == name;
+    });
+    AR_CORE_ASSERT(output != m_Outputs.end(), "Tried importing subgraph texture that isn't an output");
+
+    // Several passes of the same graph may read it
+    RenderGraphTextureHandle texture;
+    if (builder->Exists(name))
+    {
+        texture = builder->GetTextureHandle(name);
+    }
+    else
+    {
+        texture = builder->ImportTexture(name, output->Texture, output->State);
+    }
+    builder->ReadTexture(texture, output->State);
+    builder->UseSubgraph(this, output->Queue);
+
+    return texture;
+}
+
+bool RenderGraphSubgraph::Update()
+{
+    AR_PROFILE_FUNCTION();
+
+    if (!m_Built)
+    {
+        Build();
+    }
+
+    m_FramesSinceEvaluation++;
+    bool due = m_Dirty || (m_Interval && m_FramesSinceEvaluation >= m_Interval);
+    if (!due)
+    {
+        return false;
+    }
+
+    m_Graph.Evaluate();
+
+    m_Dirty = false;
+    m_FramesSinceEvaluation = 0;
+
+    // From now on the outputs are imported in their state on their queue
+    if (!m_Evaluated)
+    {
+        m_Evaluated = true;
+        m_Built = false;
+    }
+    return true;
+}
+
+void RenderGraphSubgraph::Build()
+{
+    AR_PROFILE_FUNCTION();
+
+    m_Graph.Reset();
+
+    // Once evaluated, readers of the previous evaluation may still be executing on the queues of the outputs. Reading
+    // them there first hands them back from those queues, after the readers, before the passes writing them again.
+    for (QueueType queue : {QueueType::Universal, QueueType::Compute})
+    {
+        bool used = std::any_of(m_Outputs.begin(), m_Outputs.end(), [queue](const Output& output) {
+            return output.Queue == queue;
+        });
+        if (!used)
+        {
+            continue;
+        }
+
+        m_Graph.AddPass("Subgraph Inputs", [&](RenderGraphBuilder* builder) {
+            builder->SetQueue(queue);
+            builder->SetType(RenderGraphPassType::Other);
+
+            for (const Output& output : m_Outputs)
+            {
+                if (output.Queue != queue)
+                {
+                    continue;
+                }
+
+                if (m_Evaluated)
+                {
+                    RenderGraphTextureHandle texture = builder->ImportTexture(output.Name, output.Texture, output.State);
+                    builder->ReadTexture(texture, output.State);
+                }
+                else
+                {
+                    builder->ImportTexture(output.Name, output.Texture);
+                }
+            }
+
+            return [](RenderGraphRegistry*, CommandBuffer*) {};
+        });
+    }
+
+    m_Construct(&m_Graph);
+
+    // Hands the outputs over to the queues that read them, in the state they are read in
+    for (QueueType queue : {QueueType::Universal, QueueType::Compute})
+    {
+        bool used = std::any_of(m_Outputs.begin(), m_Outputs.end(), [queue](const Output& output) {
+            return output.Queue == queue;
+        });
+        if (!used)
+        {
+            continue;
+        }
+
+        m_Graph.AddPass("Subgraph Outputs", [&](RenderGraphBuilder* builder) {
+            builder->SetQueue(queue);
+            builder->SetType(RenderGraphPassType::Other);
+
+            for (const Output& output : m_Outputs)
+            {
+                if (output.Queue == queue)
+                {
+                    builder->ReadTexture(output.Name, output.State);
+                }
+            }
+
+            return [](RenderGraphRegistry*, CommandBuffer*) {};
+        });
+    }
+    m_Graph.Compile();
+
+    m_Built = true;
+}
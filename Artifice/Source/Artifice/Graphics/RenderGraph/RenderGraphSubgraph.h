@@ -0,0 +1,70 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <functional>
+
+#include "Artifice/Core/Core.h"
+
+#include "RenderGraph.h"
+
+// Passes that are kept between frames and evaluated at their own frequency, like precomputed lookup textures.
+// The passes are built and compiled once, together with their resources, and evaluated again when marked dirty or
+// every Interval frames. Other graphs read the outputs through Import, which evaluates the subgraph when due before
+// the passes of that graph.
+class RenderGraphSubgraph
+{
+public:
+    using ConstructionFunction = std::function<void(RenderGraph*)>;
+
+private:
+    // Imported texture left in State, owned by Queue, after every evaluation
+    struct Output
+    {
+        std::string Name;
+        ResourceState State;
+        QueueType Queue;
+        RenderHandle Texture;
+    };
+
+    RenderGraph m_Graph;
+    ConstructionFunction m_Construct;
+    std::vector<Output> m_Outputs;
+
+    // 0 only evaluates when dirty
+    uint32 m_Interval = 0;
+    uint32 m_FramesSinceEvaluation = 0;
+    bool m_Dirty = true;
+    bool m_Built = false;
+    // Outputs hold the result of an evaluation, they are in their state on their queue
+    bool m_Evaluated = false;
+
+public:
+    void Init(Device* device, ConstructionFunction construct, uint32 interval = 0);
+    void CleanUp();
+
+    // Imported by the subgraph, the construction function uses them by name. Readers import them in state on queue,
+    // and may only read them in that state, as the subgraph doesn't transition them back when it isn't evaluated.
+    void AddOutput(const std::string& name, RenderHandle texture, ResourceState state, QueueType queue = QueueType::Universal);
+
+    // Evaluates again the next time it is used
+    void MarkDirty() { m_Dirty = true; }
+    // Builds the passes again, when the construction function adds different ones
+    void Invalidate()
+    {
+        m_Built = false;
+        m_Dirty = true;
+    }
+    void SetInterval(uint32 interval) { m_Interval = interval; }
+
+    // Imports the output into the pass and reads it, returns the handle in the graph of the pass
+    RenderGraphTextureHandle Import(RenderGraphBuilder* builder, const std::string& name);
+
+    // Called by the graphs using it, once per frame. Returns whether the passes were evaluated.
+    bool Update();
+
+    RenderGraph::Statistics GetStats() const { return m_Graph.GetStats(); }
+
+private:
+    void Build();
+};
@@ -0,0 +1,238 @@
+#include "RenderGraphTransientAllocator.h"
+
+#include <algorithm>
+
+#include "Artifice/Debug/Instrumentor.h"
+
+
+static uint64 AlignUp(uint64 value, uint64 alignment)
+{
+    return (value + alignment - 1) / alignment * alignment;
+}
+
+void RenderGraphTransientAllocator::Init(Device* device, RenderGraphDevice* graph_device)
+{
+    m_Device = device;
+    m_GraphDevice = graph_device;
+}
+
+void RenderGraphTransientAllocator::CleanUp()
+{
+    for (FrameMemory& frame : m_Frames)
+    {
+        DestroyFrameMemory(frame);
+    }
+    m_Placements.clear();
+    m_Heaps.clear();
+    m_Requirements.clear();
+    m_LayoutHash = 0;
+}
+
+std::vector<RenderGraphTextureAlias> RenderGraphTransientAllocator::Plan(const std::vector<RenderGraphTransientTexture>& textures, RenderGraphRegistry* registry)
+{
+    AR_PROFILE_FUNCTION();
+
+    m_Placements.clear();
+    m_Heaps.clear();
+
+    for (const RenderGraphTransientTexture& texture : textures)
+    {
+        Placement placement;
+        placement.Texture = texture;
+        placement.Info = registry->GetTextureInfo(texture.TextureIndex);
+        placement.Heap = 0;
+        placement.Offset = 0;
+        placement.Size = GetRequirements(placement.Info).Size;
+        m_Placements.push_back(placement);
+    }
+
+    // Largest first, smaller textures then fill the gaps between them
+    std::stable_sort(m_Placements.begin(), m_Placements.end(), [](const Placement& a, const Placement& b) {
+        return a.Size > b.Size;
+    });
+
+    std::vector<const Placement*> conflicts;
+    for (uint32 i = 0; i < m_Placements.size(); i++)
+    {
+        Placement& placement = m_Placements[i];
+        const MemoryRequirements& requirements = GetRequirements(placement.Info);
+
+        // One heap per set of allowed memory types
+        uint32 heap_index = 0;
+        while (heap_index < m_Heaps.size() && m_Heaps[heap_index].MemoryTypeBits != requirements.MemoryTypeBits)
+        {
+            heap_index++;
+        }
+        if (heap_index == m_Heaps.size())
+        {
+            MemoryHeap heap;
+            heap.MemoryTypeBits = requirements.MemoryTypeBits;
+            m_Heaps.push_back(heap);
+        }
+
+        // Memory ranges of the already placed textures that are alive at the same time
+        conflicts.clear();
+        for (uint32 j = 0; j < i; j++)
+        {
+            const Placement& other = m_Placements[j];
+            if (other.Heap == heap_index && !CanAlias(other.Texture, placement.Texture))
+            {
+                conflicts.push_back(&other);
+            }
+        }
+        std::sort(conflicts.begin(), conflicts.end(), [](const Placement* a, const Placement* b) {
+            return a->Offset < b->Offset;
+        });
+
+        // First gap that fits
+        uint64 offset = 0;
+        for (const Placement* other : conflicts)
+        {
+            offset = AlignUp(offset, requirements.Alignment);
+            if (offset + placement.Size <= other->Offset)
+            {
+                break;
+            }
+            offset = std::max(offset, other->Offset + other->Size);
+        }
+        offset = AlignUp(offset, requirements.Alignment);
+
+        placement.Heap = heap_index;
+        placement.Offset = offset;
+        m_Heaps[heap_index].Size = std::max(m_Heaps[heap_index].Size, offset + placement.Size);
+    }
+
+    std::vector<RenderGraphTextureAlias> aliases;
+    for (const Placement& previous : m_Placements)
+    {
+        for (const Placement& next : m_Placements)
+        {
+            if (previous.Heap != next.Heap || previous.Texture.LastPass >= next.Texture.FirstPass)
+            {
+                continue;
+            }
+            bool overlaps = previous.Offset < next.Offset + next.Size && next.Offset < previous.Offset + previous.Size;
+            if (overlaps)
+            {
+                aliases.push_back({previous.Texture.TextureIndex, next.Texture.TextureIndex});
+            }
+        }
+    }
+
+    Hasher hasher;
+    for (const MemoryHeap& heap : m_Heaps)
+    {
+        hasher.u64(heap.Size);
+        hasher.u32(heap.MemoryTypeBits);
+    }
+    for (const Placement& placement : m_Placements)
+    {
+        HashTextureInfo(hasher, placement.Info);
+        hasher.u32(placement.Heap);
+        hasher.u64(placement.Offset);
+    }
+    m_LayoutHash = hasher.GetHash();
+
+    return aliases;
+}
+
+void RenderGraphTransientAllocator::Assign(RenderGraphRegistry* registry)
+{
+    AR_PROFILE_FUNCTION();
+
+    // Textures of this frame slot are no longer in use by the GPU once the frame has begun
+    FrameMemory& frame = m_Frames[m_Device->GetFrameIndex()];
+    if (frame.LayoutHash != m_LayoutHash)
+    {
+        DestroyFrameMemory(frame);
+
+        for (const MemoryHeap& heap : m_Heaps)
+        {
+            frame.Heaps.push_back(m_Device->AllocateMemoryHeap(heap.Size, heap.MemoryTypeBits));
+        }
+        for (const Placement& placement : m_Placements)
+        {
+            frame.Textures.push_back(m_Device->CreatePlacedTexture(placement.Info, frame.Heaps[placement.Heap], placement.Offset));
+        }
+        frame.LayoutHash = m_LayoutHash;
+    }
+
+    for (uint32 i = 0; i < m_Placements.size(); i++)
+    {
+        registry->SetTexture(m_Placements[i].Texture.TextureIndex, frame.Textures[i]);
+    }
+}
+
+uint64 RenderGraphTransientAllocator::GetHeapMemory() const
+{
+    uint64 size = 0;
+    for (const MemoryHeap& heap : m_Heaps)
+    {
+        size += heap.Size;
+    }
+    return size;
+}
+
+uint64 RenderGraphTransientAllocator::GetTextureMemory() const
+{
+    uint64 size = 0;
+    for (const Placement& placement : m_Placements)
+    {
+        size += placement.Size;
+    }
+    return size;
+}
+
+void RenderGraphTransientAllocator::HashTextureInfo(Hasher& hasher, const TextureInfo& info)
+{
+    hasher.u32((uint32)info.Type);
+    hasher.u32((uint32)info.BindFlags);
+    hasher.u32(info.Width);
+    hasher.u32(info.Height);
+    hasher.u32(info.Depth);
+    hasher.u32(info.Layers);
+    hasher.u32(info.MipsEnabled);
+    hasher.u32((uint32)info.Format);
+    hasher.u32((uint32)info.Samples);
+}
+
+const MemoryRequirements& RenderGraphTransientAllocator::GetRequirements(const TextureInfo& info)
+{
+    auto find = m_Requirements.find(info);
+    if (find != m_Requirements.end())
+    {
+        return find->second;
+    }
+
+    return m_Requirements[info] = m_GraphDevice->GetTextureMemoryRequirements(info);
+}
+
+void RenderGraphTransientAllocator::DestroyFrameMemory(FrameMemory& frame)
+{
+    // Both are deferred by the device until the frames using them are done
+    for (RenderHandle texture : frame.Textures)
+    {
+        m_Device->DestroyTexture(texture);
+    }
+    for (const MemoryHeap& heap : frame.Heaps)
+    {
+        m_Device->FreeMemoryHeap(heap);
+    }
+    frame.Textures.clear();
+    frame.Heaps.clear();
+    frame.LayoutHash = 0;
+}
+
+bool RenderGraphTransientAllocator::CanAlias(const RenderGraphTransientTexture& a, const RenderGraphTransientTexture& b)
+{
+    // Only handed over on the same queue, which executes the passes in order
+    if (a.LastPass < b.FirstPass)
+    {
+        return a.LastQueue == b.FirstQueue;
+    }
+    if (b.LastPass < a.FirstPass)
+    {
+        return b.LastQueue == a.FirstQueue;
+    }
+    return false;
+}
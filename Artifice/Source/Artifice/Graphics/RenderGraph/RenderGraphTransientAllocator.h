@@ -0,0 +1,85 @@
+#pragma once
+
+#include <vector>
+#include <map>
+
+#include "Artifice/Core/Core.h"
+#include "Artifice/Graphics/Device.h"
+#include "Artifice/Graphics/Resources.h"
+#include "Artifice/Utils/Hash.h"
+
+#include "RenderGraphRegistry.h"
+#include "RenderGraphDevice.h"
+
+// Texture created by the graph, alive from its first to its last pass
+struct RenderGraphTransientTexture
+{
+    uint32 TextureIndex;
+    uint32 FirstPass;
+    uint32 LastPass;
+    QueueType FirstQueue;
+    QueueType LastQueue;
+};
+
+// Next takes over (part of) the memory of Previous, both are texture indices
+struct RenderGraphTextureAlias
+{
+    uint32 Previous;
+    uint32 Next;
+};
+
+// Places the transient textures of a graph in shared memory heaps. Textures whose lifetimes don't overlap may be
+// placed at overlapping offsets, so several full resolution targets used by different passes share one allocation.
+// Every frame in flight gets its own heaps and textures, they are only recreated when the layout changes.
+class RenderGraphTransientAllocator
+{
+private:
+    struct Placement
+    {
+        RenderGraphTransientTexture Texture;
+        TextureInfo Info;
+        uint32 Heap;
+        uint64 Offset;
+        uint64 Size;
+    };
+    struct FrameMemory
+    {
+        uint64 LayoutHash = 0;
+        std::vector<MemoryHeap> Heaps;
+        // Indexed like m_Placements
+        std::vector<RenderHandle> Textures;
+    };
+
+    // Creates the textures, planning only needs the graph device
+    Device* m_Device;
+    RenderGraphDevice* m_GraphDevice;
+    std::map<TextureInfo, MemoryRequirements> m_Requirements;
+
+    // Layout of the last plan, heaps only have their size and memory type bits
+    std::vector<Placement> m_Placements;
+    std::vector<MemoryHeap> m_Heaps;
+    uint64 m_LayoutHash = 0;
+
+    FrameMemory m_Frames[AR_FRAME_COUNT];
+
+public:
+    void Init(Device* device, RenderGraphDevice* graph_device);
+    void CleanUp();
+
+    // Computes the layout of the textures, returns the pairs that share memory.
+    std::vector<RenderGraphTextureAlias> Plan(const std::vector<RenderGraphTransientTexture>& textures, RenderGraphRegistry* registry);
+    // Gives the transient textures of this frame to the registry, creating them if the layout changed
+    void Assign(RenderGraphRegistry* registry);
+
+    // Memory of the heaps, and what the textures would take without aliasing
+    uint64 GetHeapMemory() const;
+    uint64 GetTextureMemory() const;
+
+    static void HashTextureInfo(Hasher& hasher, const TextureInfo& info);
+
+private:
+    const MemoryRequirements& GetRequirements(const TextureInfo& info);
+    void DestroyFrameMemory(FrameMemory& frame);
+
+    static bool CanAlias(const RenderGraphTransientTexture& a, const RenderGraphTransientTexture& b);
+};
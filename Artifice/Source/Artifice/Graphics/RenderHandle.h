@@ -4,6 +4,8 @@
 #include <unordered_map>
 #include <unordered_set>
 #include <deque>
+#include <mutex>
+#include <shared_mutex>
 
 #include <vulkan/vulkan.h>
 
@@ -165,30 +167,39 @@ namespace std
 
 
 
+// Resources are looked up while passes record on several threads, which may also create scratch buffers and
+// descriptor sets. Pointers stay valid until the resource is removed, the map only stores nodes.
 template <RenderHandleType TYPE, typename RESOURCE>
 class RenderHandleResourceStorage
 {
 private:
     std::unordered_map<RenderHandle, RESOURCE> m_Resources;
+    std::shared_mutex m_Mutex;
 public:
     void Add(RenderHandle handle, RESOURCE resource)
     {
         AR_CORE_ASSERT(handle.GetType() == TYPE, "")
 
+        std::unique_lock<std::shared_mutex> lock(m_Mutex);
         m_Resources.insert({handle, resource});
     }
 
     RESOURCE* Get(RenderHandle handle)
     {
         AR_CORE_ASSERT(handle.GetType() == TYPE, "")
-        AR_CORE_ASSERT(m_Resources.count(handle), "")
 
-        return &m_Resources[handle];
+        std::shared_lock<std::shared_mutex> lock(m_Mutex);
+        auto find = m_Resources.find(handle);
+        AR_CORE_ASSERT(find != m_Resources.end(), "")
+
+        return &find->second;
     }
 
     void Remove(RenderHandle handle)
     {
         AR_CORE_ASSERT(handle.GetType() == TYPE, "")
+
+        std::unique_lock<std::shared_mutex> lock(m_Mutex);
         AR_CORE_ASSERT(m_Resources.count(handle), "")
 
         m_Resources.erase(handle);
@@ -211,13 +222,16 @@ private:
 
     uint16 m_NextIDs[(uint8)RenderHandleType::Count] = {};
 
+    std::mutex m_Mutex;
+
 public:
     RenderHandleAllocator() = default;
 
     void Advance()
     {
         AR_PROFILE_FUNCTION();
-        
+
+        std::lock_guard<std::mutex> lock(m_Mutex);
         for (uint8 i = 0; i < (uint8)RenderHandleType::Count; i++)
         {
             // TODO
@@ -245,6 +259,7 @@ public:
 
         uint8 type_index = (uint8)type;
 
+        std::lock_guard<std::mutex> lock(m_Mutex);
         uint32 id;
         if (m_FreeIDs[type_index].size())
         {
@@ -270,12 +285,14 @@ public:
         
         AR_CORE_ASSERT(IsValid(handle), "");
 
+        std::lock_guard<std::mutex> lock(m_Mutex);
         m_ActiveIDs[(uint8)handle.GetType()].erase(handle.GetID());
         m_InvalidIDs[(uint8)handle.GetType()][0].push_back(handle.GetID());
     }
 
     bool IsValid(const RenderHandle& handle)
     {
+        std::lock_guard<std::mutex> lock(m_Mutex);
         return m_ActiveIDs[(uint8)handle.GetType()].find(handle.GetID()) != m_ActiveIDs[(uint8)handle.GetType()].end();
     }
 };
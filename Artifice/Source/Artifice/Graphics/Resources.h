@@ -494,6 +494,23 @@ struct Texture
     uint32 Mips;
 
     bool IsSwapchainTexture = false;
+    // Placed textures live in a MemoryHeap, which is freed separately
+    bool OwnsMemory = true;
+};
+
+// Block of device memory that textures can be placed in at an offset, see Device::CreatePlacedTexture
+struct MemoryHeap
+{
+    VkDeviceMemory Memory = VK_NULL_HANDLE;
+    uint64 Size = 0;
+    uint32 MemoryTypeBits = 0;
+};
+
+struct MemoryRequirements
+{
+    uint64 Size;
+    uint64 Alignment;
+    uint32 MemoryTypeBits;
 };
 
 struct Sampler
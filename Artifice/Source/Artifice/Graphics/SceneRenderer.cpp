@@ -82,9 +82,12 @@ struct SceneRendererData
     struct DrawCommand
     {
         Mesh* Mesh;
-        mat4 Transform;
+        // Range in Transforms
+        uint32 FirstTransform;
+        uint32 InstanceCount;
     };
     std::vector<DrawCommand> DrawList;
+    std::vector<mat4> Transforms;
 
     SceneRendererOptions Options;
 
@@ -318,7 +321,7 @@ void SceneRenderer::EndScene()
     uint32 submesh_count = 0;
     for (auto& command : s_Data.DrawList)
     {
-        submesh_count += command.Mesh->GetSubmeshes().size();
+        submesh_count += command.Mesh->GetSubmeshes().size() * command.InstanceCount;
     }
 
     MeshUniformBuffer* mesh_ub = alloc.Allocate<MeshUniformBuffer>(mesh_count);
@@ -337,13 +340,17 @@ void SceneRenderer::EndScene()
         }
         //memcpy(&mesh_ub[mesh_index].BoneTransform, bones.data(), bones.size()); 
 
+        // Instances of a submesh are consecutive
         for (auto& submesh : submeshes)
         {
-            mat4 transform = command.Transform * submesh.Transform;
-            submesh_ub[submesh_index].Transform = transform;
-            submesh_ub[submesh_index].NormalTransform = transform.inverse().transpose();
-            
-            submesh_index++;
+            for (uint32 i = 0; i < command.InstanceCount; i++)
+            {
+                mat4 transform = s_Data.Transforms[command.FirstTransform + i] * submesh.Transform;
+                submesh_ub[submesh_index].Transform = transform;
+                submesh_ub[submesh_index].NormalTransform = transform.inverse().transpose();
+
+                submesh_index++;
+            }
         }
 
         mesh_index++;
@@ -383,24 +390,29 @@ void SceneRenderer::EndScene()
         {
             systems[submesh.MaterialIndex]->Bind(s_Data.CommandBuffer);
 
-            if (is_animated)
-            {
-                s_Data.AnimatedSubmeshSystem.Bind(s_Data.CommandBuffer, submesh_index);
-            }
-            else
+            // The shaders read the transform from a dynamic uniform buffer, so each instance is its own draw with a new offset
+            for (uint32 i = 0; i < command.InstanceCount; i++)
             {
-                s_Data.StaticSubmeshSystem.Bind(s_Data.CommandBuffer, submesh_index);
+                if (is_animated)
+                {
+                    s_Data.AnimatedSubmeshSystem.Bind(s_Data.CommandBuffer, submesh_index);
+                }
+                else
+                {
+                    s_Data.StaticSubmeshSystem.Bind(s_Data.CommandBuffer, submesh_index);
+                }
+
+                s_Data.CommandBuffer->DrawIndexed(submesh.IndexCount, 1, submesh.BaseIndex, submesh.BaseVertex, 0);
+
+                submesh_index++;
             }
-
-            s_Data.CommandBuffer->DrawIndexed(submesh.IndexCount, 1, submesh.BaseIndex, submesh.BaseVertex, 0);
-
-            submesh_index++;
         }
 
         mesh_index++;
     }
 
     s_Data.DrawList.clear();
+    s_Data.Transforms.clear();
 }
 
 void SceneRenderer::DrawComposite(RenderHandle texture, RenderPassLayout rpl, CommandBuffer* cmd)
@@ -421,7 +433,20 @@ void SceneRenderer::SubmitMesh(Mesh* mesh, const mat4& transform)
 {
     AR_PROFILE_FUNCTION();
 
-    s_Data.DrawList.push_back({mesh, transform});
+    SubmitMeshInstances(mesh, &transform, 1);
+}
+
+void SceneRenderer::SubmitMeshInstances(Mesh* mesh, const mat4* transforms, uint32 count)
+{
+    AR_PROFILE_FUNCTION();
+
+    if (count == 0)
+    {
+        return;
+    }
+
+    s_Data.DrawList.push_back({mesh, (uint32)s_Data.Transforms.size(), count});
+    s_Data.Transforms.insert(s_Data.Transforms.end(), transforms, transforms + count);
 }
 
 void SceneRenderer::LoadShaders()
@@ -44,6 +44,8 @@ public:
     static void DrawComposite(RenderHandle texture, RenderPassLayout rpl, CommandBuffer* cmd);
 
     static void SubmitMesh(Mesh* mesh, const mat4& transform = mat4::identity());
+    // Draws the mesh once per transform, the mesh, pipeline and materials are bound once for all instances
+    static void SubmitMeshInstances(Mesh* mesh, const mat4* transforms, uint32 count);
 
     static PrecomputedIBLData CreateEnvironmentMap(const std::string& filepath);
     static PrecomputedIBLData CreateEnvironmentMap(RenderGraph* graph, const std::string& cube_name, uint32 cube_size);
@@ -7,15 +7,31 @@
 #include "Artifice/Graphics/Mesh.h"
 #include "Artifice/math/math.h"
 
+#include "Entity.h"
+
 struct TagComponent
 {
     std::string Tag;
 };
 
+// World space transform, computed by TransformHierarchy for entities with a LocalTransformComponent
 struct TransformComponent
 {
     mat4 Transform = mat4(1.0f);
 };
+using WorldTransformComponent = TransformComponent;
+
+// Transform relative to the parent, or to the world without a ParentComponent
+struct LocalTransformComponent
+{
+    mat4 Transform = mat4(1.0f);
+};
+
+// Parent must have a TransformComponent, otherwise the entity is treated as a root
+struct ParentComponent
+{
+    EntityHandle Parent;
+};
 
 struct CameraComponent
 {
@@ -23,8 +39,11 @@ struct CameraComponent
     bool Primary = true;
 };
 
+// Shared, entities using the same mesh are stored together and drawn per chunk
 struct MeshComponent
 {
+    static constexpr bool Shared = true;
+
     Mesh* Mesh;
 };
 
@@ -0,0 +1,319 @@
+#include "DynamicBVH.h"
+
+#include <algorithm>
+
+void DynamicBVH::Init(float margin)
+{
+    m_Margin = margin;
+}
+
+void DynamicBVH::CleanUp()
+{
+    m_Nodes.clear();
+    m_Root = AR_BVH_NULL_NODE;
+    m_FreeList = AR_BVH_NULL_NODE;
+    m_ProxyCount = 0;
+}
+
+int32 DynamicBVH::CreateProxy(const AABB& box, uint32 user_data)
+{
+    int32 proxy = AllocateNode();
+    m_Nodes[proxy].Box = box.Expanded(m_Margin);
+    m_Nodes[proxy].UserData = user_data;
+    m_Nodes[proxy].Height = 0;
+
+    InsertLeaf(proxy);
+    m_ProxyCount++;
+
+    return proxy;
+}
+
+void DynamicBVH::DestroyProxy(int32 proxy)
+{
+    AR_CORE_ASSERT(proxy >= 0 && proxy < (int32)m_Nodes.size() && m_Nodes[proxy].IsLeaf() && m_Nodes[proxy].Height == 0,
+                   "Tried destroying invalid BVH proxy");
+
+    RemoveLeaf(proxy);
+    FreeNode(proxy);
+    m_ProxyCount--;
+}
+
+bool DynamicBVH::MoveProxy(int32 proxy, const AABB& box)
+{
+    AR_CORE_ASSERT(proxy >= 0 && proxy < (int32)m_Nodes.size() && m_Nodes[proxy].IsLeaf() && m_Nodes[proxy].Height == 0,
+                   "Tried moving invalid BVH proxy");
+
+    // Shrinking objects are reinserted too, so fat boxes stay tight
+    const AABB& fat_box = m_Nodes[proxy].Box;
+    if (fat_box.Contains(box) && box.Expanded(m_Margin * 4.0f).Contains(fat_box))
+    {
+        return false;
+    }
+
+    RemoveLeaf(proxy);
+    m_Nodes[proxy].Box = box.Expanded(m_Margin);
+    InsertLeaf(proxy);
+
+    return true;
+}
+
+int32 DynamicBVH::AllocateNode()
+{
+    if (m_FreeList == AR_BVH_NULL_NODE)
+    {
+        m_Nodes.emplace_back();
+        m_FreeList = m_Nodes.size() - 1;
+    }
+
+    int32 node = m_FreeList;
+    m_FreeList = m_Nodes[node].Parent;
+
+    m_Nodes[node] = Node();
+    m_Nodes[node].Height = 0;
+    return node;
+}
+
+void DynamicBVH::FreeNode(int32 node)
+{
+    m_Nodes[node].Parent = m_FreeList;
+    m_Nodes[node].Height = -1;
+    m_FreeList = node;
+}
+
+void DynamicBVH::InsertLeaf(int32 leaf)
+{
+    if (m_Root == AR_BVH_NULL_NODE)
+    {
+        m_Root = leaf;
+        m_Nodes[leaf].Parent = AR_BVH_NULL_NODE;
+        return;
+    }
+
+    // Descend to the sibling with the lowest cost, the cost of a node is the surface area it adds to the tree
+    AABB leaf_box = m_Nodes[leaf].Box;
+    int32 index = m_Root;
+    while (!m_Nodes[index].IsLeaf())
+    {
+        const Node& node = m_Nodes[index];
+        const Node& child1 = m_Nodes[node.Child1];
+        const Node& child2 = m_Nodes[node.Child2];
+
+        float area = node.Box.GetSurfaceArea();
+        float combined_area = AABB::Merge(node.Box, leaf_box).GetSurfaceArea();
+
+        // Cost of a new parent for this node and the leaf
+        float cost = 2.0f * combined_area;
+        // Every ancestor of a deeper sibling grows by at least this
+        float inheritance_cost = 2.0f * (combined_area - area);
+
+        float cost1 = AABB::Merge(leaf_box, child1.Box).GetSurfaceArea() + inheritance_cost;
+        if (!child1.IsLeaf())
+        {
+            cost1 -= child1.Box.GetSurfaceArea();
+        }
+        float cost2 = AABB::Merge(leaf_box, child2.Box).GetSurfaceArea() + inheritance_cost;
+        if (!child2.IsLeaf())
+        {
+            cost2 -= child2.Box.GetSurfaceArea();
+        }
+
+        if (cost < cost1 && cost < cost2)
+        {
+            break;
+        }
+
+        index = cost1 < cost2 ? node.Child1 : node.Child2;
+    }
+
+    int32 sibling = index;
+    int32 old_parent = m_Nodes[sibling].Parent;
+    // May reallocate the node array
+    int32 new_parent = AllocateNode();
+
+    m_Nodes[new_parent].Parent = old_parent;
+    m_Nodes[new_parent].Box = AABB::Merge(leaf_box, m_Nodes[sibling].Box);
+    m_Nodes[new_parent].Height = m_Nodes[sibling].Height + 1;
+    m_Nodes[new_parent].Child1 = sibling;
+    m_Nodes[new_parent].Child2 = leaf;
+    m_Nodes[sibling].Parent = new_parent;
+    m_Nodes[leaf].Parent = new_parent;
+
+    if (old_parent == AR_BVH_NULL_NODE)
+    {
+        m_Root = new_parent;
+    }
+    else if (m_Nodes[old_parent].Child1 == sibling)
+    {
+        m_Nodes[old_parent].Child1 = new_parent;
+    }
+    else
+    {
+        m_Nodes[old_parent].Child2 = new_parent;
+    }
+
+    FixUpwards(new_parent);
+}
+
+void DynamicBVH::RemoveLeaf(int32 leaf)
+{
+    if (leaf == m_Root)
+    {
+        m_Root = AR_BVH_NULL_NODE;
+        return;
+    }
+
+    int32 parent = m_Nodes[leaf].Parent;
+    int32 grandparent = m_Nodes[parent].Parent;
+    int32 sibling = m_Nodes[parent].Child1 == leaf ? m_Nodes[parent].Child2 : m_Nodes[parent].Child1;
+
+    // Sibling takes the place of the parent
+    m_Nodes[sibling].Parent = grandparent;
+    FreeNode(parent);
+
+    if (grandparent == AR_BVH_NULL_NODE)
+    {
+        m_Root = sibling;
+        return;
+    }
+
+    if (m_Nodes[grandparent].Child1 == parent)
+    {
+        m_Nodes[grandparent].Child1 = sibling;
+    }
+    else
+    {
+        m_Nodes[grandparent].Child2 = sibling;
+    }
+    FixUpwards(grandparent);
+}
+
+void DynamicBVH::FixUpwards(int32 index)
+{
+    while (index != AR_BVH_NULL_NODE)
+    {
+        index = Balance(index);
+
+        Node& node = m_Nodes[index];
+        const Node& child1 = m_Nodes[node.Child1];
+        const Node& child2 = m_Nodes[node.Child2];
+        node.Height = 1 + std::max(child1.Height, child2.Height);
+        node.Box = AABB::Merge(child1.Box, child2.Box);
+
+        index = node.Parent;
+    }
+}
+
+int32 DynamicBVH::Balance(int32 index_a)
+{
+    Node& a = m_Nodes[index_a];
+    if (a.IsLeaf() || a.Height < 2)
+    {
+        return index_a;
+    }
+
+    int32 index_b = a.Child1;
+    int32 index_c = a.Child2;
+    Node& b = m_Nodes[index_b];
+    Node& c = m_Nodes[index_c];
+
+    int32 balance = c.Height - b.Height;
+    if (balance > 1)
+    {
+        // C becomes the parent of A, A keeps B and the shorter child of C
+        int32 index_f = c.Child1;
+        int32 index_g = c.Child2;
+        Node& f = m_Nodes[index_f];
+        Node& g = m_Nodes[index_g];
+
+        c.Child1 = index_a;
+        c.Parent = a.Parent;
+        a.Parent = index_c;
+
+        if (c.Parent == AR_BVH_NULL_NODE)
+        {
+            m_Root = index_c;
+        }
+        else if (m_Nodes[c.Parent].Child1 == index_a)
+        {
+            m_Nodes[c.Parent].Child1 = index_c;
+        }
+        else
+        {
+            m_Nodes[c.Parent].Child2 = index_c;
+        }
+
+        if (f.Height > g.Height)
+        {
+            c.Child2 = index_f;
+            a.Child2 = index_g;
+            g.Parent = index_a;
+            a.Box = AABB::Merge(b.Box, g.Box);
+            c.Box = AABB::Merge(a.Box, f.Box);
+            a.Height = 1 + std::max(b.Height, g.Height);
+            c.Height = 1 + std::max(a.Height, f.Height);
+        }
+        else
+        {
+            c.Child2 = index_g;
+            a.Child2 = index_f;
+            f.Parent = index_a;
+            a.Box = AABB::Merge(b.Box, f.Box);
+            c.Box = AABB::Merge(a.Box, g.Box);
+            a.Height = 1 + std::max(b.Height, f.Height);
+            c.Height = 1 + std::max(a.Height, g.Height);
+        }
+
+        return index_c;
+    }
+
+    if (balance < -1)
+    {
+        // B becomes the parent of A, A keeps C and the shorter child of B
+        int32 index_d = b.Child1;
+        int32 index_e = b.Child2;
+        Node& d = m_Nodes[index_d];
+        Node& e = m_Nodes[index_e];
+
+        b.Child1 = index_a;
+        b.Parent = a.Parent;
+        a.Parent = index_b;
+
+        if (b.Parent == AR_BVH_NULL_NODE)
+        {
+            m_Root = index_b;
+        }
+        else if (m_Nodes[b.Parent].Child1 == index_a)
+        {
+            m_Nodes[b.Parent].Child1 = index_b;
+        }
+        else
+        {
+            m_Nodes[b.Parent].Child2 = index_b;
+        }
+
+        if (d.Height > e.Height)
+        {
+            b.Child2 = index_d;
+            a.Child1 = index_e;
+            e.Parent = index_a;
+            a.Box = AABB::Merge(c.Box, e.Box);
+            b.Box = AABB::Merge(a.Box, d.Box);
+            a.Height = 1 + std::max(c.Height, e.Height);
+            b.Height = 1 + std::max(a.Height, d.Height);
+        }
+        else
+        {
+            b.Child2 = index_e;
+            a.Child1 = index_d;
+            d.Parent = index_a;
+            a.Box = AABB::Merge(c.Box, d.Box);
+            b.Box = AABB::Merge(a.Box, e.Box);
+            a.Height = 1 + std::max(c.Height, d.Height);
+            b.Height = 1 + std::max(a.Height, e.Height);
+        }
+
+        return index_b;
+    }
+
+    return index_a;
+}
@@ -0,0 +1,166 @@
+#pragma once
+
+#include <vector>
+
+#include "Artifice/Core/Core.h"
+#include "Artifice/Core/Log.h"
+#include "Artifice/math/AABB.h"
+#include "Artifice/math/Frustum.h"
+
+#define AR_BVH_NULL_NODE -1
+// Traversal stack size, the tree is height balanced so this is far more than needed
+#define AR_BVH_STACK_SIZE 256
+
+// Dynamic AABB tree. Leaves (proxies) store boxes enlarged by a margin, so objects moving less than the margin don't
+// need to be reinserted. Inserting picks the sibling with the lowest surface area cost, and rotations keep the
+// tree height balanced.
+class DynamicBVH
+{
+private:
+    struct Node
+    {
+        AABB Box;
+        uint32 UserData = 0;
+        // Next free node while on the free list
+        int32 Parent = AR_BVH_NULL_NODE;
+        int32 Child1 = AR_BVH_NULL_NODE;
+        int32 Child2 = AR_BVH_NULL_NODE;
+        // 0 for leaves, -1 for free nodes
+        int32 Height = -1;
+
+        bool IsLeaf() const { return Child1 == AR_BVH_NULL_NODE; }
+    };
+
+    std::vector<Node> m_Nodes;
+    int32 m_Root = AR_BVH_NULL_NODE;
+    int32 m_FreeList = AR_BVH_NULL_NODE;
+    uint32 m_ProxyCount = 0;
+    float m_Margin = 0.1f;
+
+public:
+    void Init(float margin = 0.1f);
+    void CleanUp();
+
+    int32 CreateProxy(const AABB& box, uint32 user_data);
+    void DestroyProxy(int32 proxy);
+    // Reinserts the proxy if box left its fat box, or is much smaller than it. Returns whether it was reinserted.
+    bool MoveProxy(int32 proxy, const AABB& box);
+
+    const AABB& GetFatAABB(int32 proxy) const { return m_Nodes[proxy].Box; }
+    uint32 GetUserData(int32 proxy) const { return m_Nodes[proxy].UserData; }
+    uint32 GetProxyCount() const { return m_ProxyCount; }
+    uint32 GetHeight() const { return m_Root == AR_BVH_NULL_NODE ? 0 : m_Nodes[m_Root].Height; }
+
+    // Calls func(user_data) for every proxy whose fat box overlaps box
+    template <class F>
+    void QueryOverlap(const AABB& box, F&& func) const
+    {
+        Traverse([&box](const AABB& node_box) { return node_box.Overlaps(box); }, func);
+    }
+
+    // Calls func(user_data) for every proxy whose fat box is at least partially inside the frustum
+    template <class F>
+    void QueryFrustum(const Frustum& frustum, F&& func) const
+    {
+        Traverse([&frustum](const AABB& node_box) { return frustum.IsBoxVisible(node_box); }, func);
+    }
+
+    // Calls func(user_data, max_distance) for every proxy whose fat box the ray hits within max_distance, closest
+    // subtree first. func returns the new max distance, so returning the distance of a hit clips the ray to it.
+    template <class F>
+    void QueryRay(const vec3& origin, const vec3& direction, float max_distance, F&& func) const
+    {
+        if (m_Root == AR_BVH_NULL_NODE)
+        {
+            return;
+        }
+
+        vec3 inverse_direction(1.0f / direction.x, 1.0f / direction.y, 1.0f / direction.z);
+
+        int32 stack[AR_BVH_STACK_SIZE];
+        uint32 count = 0;
+        stack[count++] = m_Root;
+        while (count > 0)
+        {
+            const Node& node = m_Nodes[stack[--count]];
+
+            float distance;
+            if (!node.Box.IntersectRay(origin, inverse_direction, max_distance, distance))
+            {
+                continue;
+            }
+
+            if (node.IsLeaf())
+            {
+                max_distance = func(node.UserData, max_distance);
+                continue;
+            }
+
+            float distance1, distance2;
+            bool hit1 = m_Nodes[node.Child1].Box.IntersectRay(origin, inverse_direction, max_distance, distance1);
+            bool hit2 = m_Nodes[node.Child2].Box.IntersectRay(origin, inverse_direction, max_distance, distance2);
+
+            AR_CORE_ASSERT(count + 2 <= AR_BVH_STACK_SIZE, "BVH traversal stack overflow");
+            // Pushed last is visited first
+            if (hit1 && hit2 && distance2 < distance1)
+            {
+                stack[count++] = node.Child1;
+                stack[count++] = node.Child2;
+            }
+            else
+            {
+                if (hit2)
+                {
+                    stack[count++] = node.Child2;
+                }
+                if (hit1)
+                {
+                    stack[count++] = node.Child1;
+                }
+            }
+        }
+    }
+
+private:
+    template <class T, class F>
+    void Traverse(const T& test, F& func) const
+    {
+        if (m_Root == AR_BVH_NULL_NODE)
+        {
+            return;
+        }
+
+        int32 stack[AR_BVH_STACK_SIZE];
+        uint32 count = 0;
+        stack[count++] = m_Root;
+        while (count > 0)
+        {
+            const Node& node = m_Nodes[stack[--count]];
+            if (!test(node.Box))
+            {
+                continue;
+            }
+
+            if (node.IsLeaf())
+            {
+                func(node.UserData);
+            }
+            else
+            {
+                AR_CORE_ASSERT(count + 2 <= AR_BVH_STACK_SIZE, "BVH traversal stack overflow");
+                stack[count++] = node.Child1;
+                stack[count++] = node.Child2;
+            }
+        }
+    }
+
+    int32 AllocateNode();
+    void FreeNode(int32 node);
+
+    void InsertLeaf(int32 leaf);
+    void RemoveLeaf(int32 leaf);
+    // Refits boxes and heights from index to the root, balancing on the way
+    void FixUpwards(int32 index);
+    // Rotates the taller child of an unbalanced node up, returns the node now at its place
+    int32 Balance(int32 index);
+};
@@ -1 +1,194 @@
-#include "Entity.h"
\ No newline at end of file
+#include "Entity.h"
+
+
+static uint32 AlignUp(uint32 value, uint32 alignment)
+{
+    return (value + alignment - 1) & ~(alignment - 1);
+}
+
+void Archetype::Init(const ArchetypeDescription& desc, const uint32* component_sizes, const ComponentSignature& shared_components, const uint8* shared_data,
+                     std::atomic<uint32>* change_version)
+{
+    Description = desc;
+    ChangeVersion = change_version;
+
+    for (uint32 i = 0; i < AR_ECS_MAX_COMPONENTS; i++)
+    {
+        ColumnIndices[i] = -1;
+    }
+
+    // Shared components are stored once, the rest get a column
+    ArchetypeDescription shared_desc;
+    shared_desc.Signature = desc.Signature & shared_components;
+    SharedTypes = shared_desc.GetComponentTypes();
+    SharedData.resize(GetSharedLayout(shared_desc.Signature, component_sizes, SharedOffsets));
+    if (SharedData.size())
+    {
+        memcpy(SharedData.data(), shared_data, SharedData.size());
+    }
+
+    ArchetypeDescription column_desc;
+    column_desc.Signature = desc.Signature & ~shared_components;
+    ComponentTypes = column_desc.GetComponentTypes();
+
+    uint32 entity_size = sizeof(EntityHandle);
+    for (uint32 column = 0; column < ComponentTypes.size(); column++)
+    {
+        uint32 comp_id = ComponentTypes[column];
+        AR_CORE_ASSERT(component_sizes[comp_id], "Tried creating archetype with component that has not been registered");
+
+        ColumnIndices[comp_id] = column;
+        ComponentSizes.push_back(component_sizes[comp_id]);
+        entity_size += component_sizes[comp_id];
+    }
+    ColumnOffsets.resize(ComponentSizes.size());
+
+    // Worst case padding is one alignment per column
+    uint32 padding = AR_ECS_COLUMN_ALIGNMENT * (ComponentSizes.size() + 1);
+    ChunkCapacity = AR_ECS_CHUNK_SIZE > padding ? (AR_ECS_CHUNK_SIZE - padding) / entity_size : 0;
+    if (ChunkCapacity == 0)
+    {
+        // Entity does not fit in a default sized chunk, use one entity per chunk
+        ChunkCapacity = 1;
+    }
+
+    // Entity handles first, then each component column
+    uint32 offset = AlignUp(ChunkCapacity * sizeof(EntityHandle), AR_ECS_COLUMN_ALIGNMENT);
+    for (uint32 i = 0; i < ComponentSizes.size(); i++)
+    {
+        ColumnOffsets[i] = offset;
+        offset = AlignUp(offset + ChunkCapacity * ComponentSizes[i], AR_ECS_COLUMN_ALIGNMENT);
+    }
+    ChunkSize = offset > AR_ECS_CHUNK_SIZE ? offset : AR_ECS_CHUNK_SIZE;
+}
+
+uint32 Archetype::GetSharedLayout(const ComponentSignature& shared_components, const uint32* component_sizes, int32* offsets)
+{
+    uint32 size = 0;
+    for (uint32 i = 0; i < AR_ECS_MAX_COMPONENTS; i++)
+    {
+        offsets[i] = -1;
+        if (shared_components.test(i))
+        {
+            offsets[i] = size;
+            size = AlignUp(size + component_sizes[i], AR_ECS_COLUMN_ALIGNMENT);
+        }
+    }
+    return size;
+}
+
+void Archetype::CleanUp()
+{
+    for (ArchetypeChunk& chunk : Chunks)
+    {
+        if (!chunk.Mapped)
+        {
+            delete[] chunk.Data;
+        }
+    }
+    Chunks.clear();
+    EntityCount = 0;
+}
+
+uint32 Archetype::PushEntity(EntityHandle entity)
+{
+    return PushEntities(&entity, 1);
+}
+
+uint32 Archetype::PushEntities(const EntityHandle* entities, uint32 count)
+{
+    uint32 first_index = EntityCount;
+    uint32 version = NextChangeVersion();
+    StructureVersion = version;
+
+    uint32 pushed = 0;
+    while (pushed < count)
+    {
+        if (Chunks.empty() || Chunks.back().Count == ChunkCapacity)
+        {
+            ArchetypeChunk chunk;
+            chunk.Data = new uint8[ChunkSize];
+            chunk.ColumnVersions.resize(ComponentSizes.size());
+            Chunks.push_back(chunk);
+        }
+
+        ArchetypeChunk& chunk = Chunks.back();
+        MarkChanged(chunk, version);
+        uint32 run = ChunkCapacity - chunk.Count;
+        if (run > count - pushed)
+        {
+            run = count - pushed;
+        }
+
+        std::copy(entities + pushed, entities + pushed + run, chunk.GetEntityHandles() + chunk.Count);
+        chunk.Count += run;
+        pushed += run;
+    }
+
+    EntityCount += count;
+
+    return first_index;
+}
+
+void Archetype::CopyComponents(Archetype* src, uint32 src_index, Archetype* dst, uint32 dst_index, uint32 count)
+{
+    // Copy in runs that do not cross a chunk boundary on either side
+    while (count)
+    {
+        uint32 src_left = src->ChunkCapacity - src_index % src->ChunkCapacity;
+        uint32 dst_left = dst->ChunkCapacity - dst_index % dst->ChunkCapacity;
+        uint32 run = count;
+        run = run < src_left ? run : src_left;
+        run = run < dst_left ? run : dst_left;
+
+        for (uint32 src_column = 0; src_column < src->ComponentTypes.size(); src_column++)
+        {
+            int32 dst_column = dst->ColumnIndices[src->ComponentTypes[src_column]];
+            if (dst_column >= 0)
+            {
+                memcpy(dst->GetComponentData(dst_column, dst_index), src->GetComponentData(src_column, src_index), run * src->ComponentSizes[src_column]);
+            }
+        }
+
+        src_index += run;
+        dst_index += run;
+        count -= run;
+    }
+}
+
+bool Archetype::RemoveEntity(uint32 index, EntityHandle& moved_entity)
+{
+    AR_CORE_ASSERT(index < EntityCount, "Tried removing entity that is not in archetype");
+
+    uint32 back_index = EntityCount - 1;
+    bool moved = index != back_index;
+    StructureVersion = NextChangeVersion();
+
+    // Swap and pop
+    if (moved)
+    {
+        moved_entity = GetEntityHandle(back_index);
+        GetChunk(index).GetEntityHandles()[index % ChunkCapacity] = moved_entity;
+        MarkChanged(GetChunk(index), StructureVersion);
+
+        for (uint32 column = 0; column < ComponentSizes.size(); column++)
+        {
+            memcpy(GetComponentData(column, index), GetComponentData(column, back_index), ComponentSizes[column]);
+        }
+    }
+
+    EntityCount--;
+
+    ArchetypeChunk& back_chunk = Chunks.back();
+    back_chunk.Count--;
+    if (back_chunk.Count == 0)
+    {
+        if (!back_chunk.Mapped)
+        {
+            delete[] back_chunk.Data;
+        }
+        Chunks.pop_back();
+    }
+
+    return moved;
+}
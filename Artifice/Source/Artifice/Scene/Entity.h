@@ -1,16 +1,29 @@
 #pragma once
 
+#include <algorithm>
+#include <atomic>
+#include <bitset>
+#include <cstring>
 #include <set>
-#include <unordered_set>
+#include <type_traits>
 #include <unordered_map>
+#include <utility>
 #include <vector>
 
 #include "Artifice/Core/Core.h"
 #include "Artifice/Core/Log.h"
+#include "Artifice/Core/JobSystem.h"
+#include "Artifice/Utils/Hash.h"
+#include "Artifice/Utils/MappedFile.h"
+
+// Entity handles pack a slot index and a generation. The generation of a slot is
+// bumped whenever it is released, so stale handles can be detected.
+#define AR_ENTITY_INDEX_BITS 24
+#define AR_ENTITY_INDEX_MASK ((1u << AR_ENTITY_INDEX_BITS) - 1)
+#define AR_ENTITY_GENERATION_MASK 0xff
 
 class EntityHandle
 {
-    template<uint32 RING_SIZE>
     friend class EntityHandleAllocator;
 
 private:
@@ -40,83 +53,76 @@ public:
     }
 
     uint32 GetCookie() const { return m_ID; }
-    uint32 GetID() const { return m_ID; }
+    uint32 GetIndex() const { return m_ID & AR_ENTITY_INDEX_MASK; }
+    uint8 GetGeneration() const { return m_ID >> AR_ENTITY_INDEX_BITS; }
 
+    // Generations start at 1, so a valid handle is never null
     bool IsNull() const { return GetCookie() == 0; }
 private:
-    void SetID(uint32 id) { m_ID = id; }
+    void Set(uint32 index, uint8 generation) { m_ID = ((uint32)generation << AR_ENTITY_INDEX_BITS) | index; }
 };
 
-template <uint32 RING_SIZE>
 class EntityHandleAllocator
 {
-    friend class EntityHandle;
-private:
-    const uint32 RingBackIndex = RING_SIZE - 1;
-
 private:
+    // Current generation of each slot
+    std::vector<uint8> m_Generations;
+    std::vector<uint32> m_FreeIndices;
 
-private:
-    std::unordered_set<uint32> m_ActiveIDs;
-    std::vector<uint32> m_InvalidIDs[RING_SIZE];
-    std::vector<uint32> m_FreeIDs;
-
-    uint32 m_NextIDs = 0;
 public:
     EntityHandleAllocator() = default;
 
-    void Advance()
-    {
-        // TODO
-        // Using an index is definitely better, so don't need to rotate rings.
-
-        // Recycle invalid ids from back ring to free list
-        m_FreeIDs.insert(m_FreeIDs.end(), m_InvalidIDs[RingBackIndex].begin(), m_InvalidIDs[RingBackIndex].end());
-
-        // Rotate the rings
-        for (uint32 i = RingBackIndex; i > 0; i--)
-        {
-            m_InvalidIDs[i] = m_InvalidIDs[i - 1];
-        }
-
-        // First ring now clear (old back ring)
-        m_InvalidIDs[0].clear();
-    }
-
     EntityHandle Allocate()
     {
-        uint32 id;
-        if (m_FreeIDs.size())
+        uint32 index;
+        if (m_FreeIndices.size())
         {
-            id = m_FreeIDs.back();
-            m_FreeIDs.pop_back();
+            index = m_FreeIndices.back();
+            m_FreeIndices.pop_back();
         }
         else
         {
-            id = m_NextIDs++;
+            index = m_Generations.size();
+            AR_CORE_ASSERT(index <= AR_ENTITY_INDEX_MASK, "Exceeded maximum entity count");
+            m_Generations.push_back(1);
         }
-        
-        m_ActiveIDs.insert(id);
 
         EntityHandle handle;
-        handle.SetID(id);
+        handle.Set(index, m_Generations[index]);
 
         return handle;
     }
 
     void Release(const EntityHandle& handle)
     {
-        uint32 id = handle.GetID();
+        AR_CORE_ASSERT(IsAlive(handle), "Tried releasing entity handle that is not active");
+
+        uint32 index = handle.GetIndex();
 
-        AR_CORE_ASSERT(IsActive(id), "Tried releasing entity handle that is not active");
+        // Skip generation 0 on wrap around, keeps released handles from becoming null
+        uint8 generation = (m_Generations[index] + 1) & AR_ENTITY_GENERATION_MASK;
+        m_Generations[index] = generation ? generation : 1;
 
-        m_ActiveIDs.erase(id);
-        m_InvalidIDs[0].push_back(id);
+        m_FreeIndices.push_back(index);
     }
-private:
-    bool IsActive(uint32 id)
+
+    bool IsAlive(const EntityHandle& handle) const
+    {
+        uint32 index = handle.GetIndex();
+        return index < m_Generations.size() && m_Generations[index] == handle.GetGeneration();
+    }
+
+    // Number of slots ever allocated, alive or free
+    uint32 GetCapacity() const { return m_Generations.size(); }
+
+    const std::vector<uint8>& GetGenerations() const { return m_Generations; }
+    const std::vector<uint32>& GetFreeIndices() const { return m_FreeIndices; }
+
+    // Replaces the allocator state, used when loading snapshots
+    void Restore(const uint8* generations, uint32 count, const uint32* free_indices, uint32 free_count)
     {
-        return m_ActiveIDs.find(id) != m_ActiveIDs.end();
+        m_Generations.assign(generations, generations + count);
+        m_FreeIndices.assign(free_indices, free_indices + free_count);
     }
 };
 
@@ -158,53 +164,181 @@ template <class C>
 class Component : public ComponentBase
 {
 public:
+    // const C shares the id of C, constness only marks read access in queries
     static uint32 GetTypeID()
     {
-        return TypeIdGenerator<ComponentBase>::GetNewID<C>();
+        return TypeIdGenerator<ComponentBase>::GetNewID<std::remove_cv_t<C>>();
     }
 };
 
+// Shared components are marked with `static constexpr bool Shared = true;`. Their value is stored once per archetype
+// instead of per entity, entities with different values are kept in different archetypes and so in different chunks.
+// Values are compared bytewise and are read only, SetSharedComponent moves the entity instead.
+template <class C, class = void>
+struct IsSharedComponent : std::false_type
+{
+};
+template <class C>
+struct IsSharedComponent<C, std::void_t<decltype(C::Shared)>> : std::integral_constant<bool, C::Shared>
+{
+};
+
+// Component ids index into a fixed width bitmask
+#define AR_ECS_MAX_COMPONENTS 64
+
+using ComponentSignature = std::bitset<AR_ECS_MAX_COMPONENTS>;
+
 struct ArchetypeDescription
 {
-    std::set<uint32> ComponentTypes;
+    ComponentSignature Signature;
+
+    void Add(uint32 id) { Signature.set(id); }
+    void Remove(uint32 id) { Signature.reset(id); }
     bool Contains(uint32 id) const
     {
-        return ComponentTypes.find(id) != ComponentTypes.end();
+        return Signature.test(id);
     }
-    uint32 GetIndex(uint32 id) const
+    bool ContainsAll(const ComponentSignature& signature) const
     {
-        uint32 index = 0;
-        for (auto& comp : ComponentTypes)
+        return (Signature & signature) == signature;
+    }
+    bool Empty() const { return Signature.none(); }
+    // Component ids in ascending order, which is also the column order
+    std::vector<uint32> GetComponentTypes() const
+    {
+        std::vector<uint32> result;
+        for (uint32 id = 0; id < AR_ECS_MAX_COMPONENTS; id++)
         {
-            if (id == comp)
+            if (Signature.test(id))
             {
-                return index;
+                result.push_back(id);
             }
-            index++;
         }
-        AR_CORE_FATAL();
+        return result;
     }
 };
 
+// Archetype storage is split into fixed size chunks. Each chunk is one contiguous
+// block holding the entity handles followed by one column per component (SoA).
+#define AR_ECS_CHUNK_SIZE (1024 * 16)
+#define AR_ECS_COLUMN_ALIGNMENT 16
+
+struct ArchetypeChunk
+{
+    uint8* Data = nullptr;
+    uint32 Count = 0;
+    // Per column, registry change version of the last write
+    std::vector<uint32> ColumnVersions;
+    // Data points into a snapshot mapping owned by the registry and is not freed
+    bool Mapped = false;
+
+    EntityHandle* GetEntityHandles() { return (EntityHandle*)Data; }
+};
+
 struct Archetype
 {
     ArchetypeDescription Description;
-    std::vector<std::vector<uint8>> ComponentData;
-    std::vector<EntityHandle> EntityHandles;
 
+    // Per column (in ascending component id order)
+    std::vector<uint32> ComponentTypes;
+    std::vector<uint32> ComponentSizes;
+    std::vector<uint32> ColumnOffsets;
+    // Component id to column, -1 if not contained or shared
+    int32 ColumnIndices[AR_ECS_MAX_COMPONENTS];
+
+    // Shared component values (in ascending component id order)
+    std::vector<uint32> SharedTypes;
+    std::vector<uint8> SharedData;
+    // Component id to offset in SharedData, -1 if not contained or not shared
+    int32 SharedOffsets[AR_ECS_MAX_COMPONENTS];
+
+    uint32 ChunkSize = 0;
+    uint32 ChunkCapacity = 0;
+    uint32 EntityCount = 0;
+    std::vector<ArchetypeChunk> Chunks;
+
+    // Owned by the registry, incremented for every write
+    std::atomic<uint32>* ChangeVersion = nullptr;
+    // Change version of the last push or removal, entity indices are stable while it is unchanged
+    uint32 StructureVersion = 0;
+
+    // Archetype graph, cached destinations of adding/removing a component (nullptr means no archetype)
+    std::unordered_map<uint32, Archetype*> AddEdges;
+    std::unordered_map<uint32, Archetype*> RemoveEdges;
+
+    // shared_data holds the values of the components in shared_components, laid out as by GetSharedLayout
+    void Init(const ArchetypeDescription& desc, const uint32* component_sizes, const ComponentSignature& shared_components, const uint8* shared_data,
+              std::atomic<uint32>* change_version);
+    void CleanUp();
+
+    // Fills offsets for the shared components and returns the size of their values
+    static uint32 GetSharedLayout(const ComponentSignature& shared_components, const uint32* component_sizes, int32* offsets);
+
+    // Appends entity to the back of the last chunk, component memory is left uninitialized
+    uint32 PushEntity(EntityHandle entity);
+    // Appends entities in order, returns the index of the first one
+    uint32 PushEntities(const EntityHandle* entities, uint32 count);
+    // Reserves chunk bookkeeping for count more entities, chunk memory is still allocated as chunks fill up
+    void Reserve(uint32 count)
+    {
+        Chunks.reserve((EntityCount + count + ChunkCapacity - 1) / ChunkCapacity);
+    }
+    // Swap and pop, returns true and the moved entity if the back entity was moved into index
+    bool RemoveEntity(uint32 index, EntityHandle& moved_entity);
+
+    // Copies count consecutive entities' components that exist in both archetypes, one memcpy per column per chunk run
+    static void CopyComponents(Archetype* src, uint32 src_index, Archetype* dst, uint32 dst_index, uint32 count);
+
+    ArchetypeChunk& GetChunk(uint32 index) { return Chunks[index / ChunkCapacity]; }
+    EntityHandle GetEntityHandle(uint32 index)
+    {
+        return GetChunk(index).GetEntityHandles()[index % ChunkCapacity];
+    }
+    uint8* GetComponentData(uint32 column, uint32 index)
+    {
+        return GetChunk(index).Data + ColumnOffsets[column] + (index % ChunkCapacity) * ComponentSizes[column];
+    }
+    uint8* GetComponentData(uint32 column, ArchetypeChunk& chunk)
+    {
+        return chunk.Data + ColumnOffsets[column];
+    }
+
+    uint32 NextChangeVersion() { return ++(*ChangeVersion); }
+    void MarkChanged(uint32 column, uint32 index)
+    {
+        GetChunk(index).ColumnVersions[column] = NextChangeVersion();
+    }
+    void MarkChanged(ArchetypeChunk& chunk, uint32 version)
+    {
+        for (uint32& column_version : chunk.ColumnVersions)
+        {
+            column_version = version;
+        }
+    }
+
+    uint32 GetColumn(uint32 comp_id) const
+    {
+        AR_CORE_ASSERT(ColumnIndices[comp_id] >= 0, "Tried getting component that archetype does not contain");
+        return ColumnIndices[comp_id];
+    }
+
+    uint8* GetSharedComponentData(uint32 comp_id)
+    {
+        AR_CORE_ASSERT(SharedOffsets[comp_id] >= 0, "Tried getting shared component that archetype does not contain");
+        return SharedData.data() + SharedOffsets[comp_id];
+    }
     template <class C>
-    C* GetComponents()
+    const C* GetSharedComponent()
     {
-        // todo check to make sure has component
-        uint32 comp_id = Component<C>::GetTypeID();
-        uint32 index = Description.GetIndex(comp_id);
-        return (C*)ComponentData[index].data();
+        static_assert(IsSharedComponent<C>::value, "GetSharedComponent requires a shared component");
+        return (const C*)GetSharedComponentData(Component<C>::GetTypeID());
     }
-    std::vector<uint8>& GetComponentData(uint32 comp_id)
+
+    template <class C>
+    C* GetComponents(ArchetypeChunk& chunk)
     {
-        // todo check to make sure valid comp id
-        uint32 index = Description.GetIndex(comp_id);
-        return ComponentData[index];
+        uint32 column = GetColumn(Component<C>::GetTypeID());
+        return (C*)GetComponentData(column, chunk);
     }
     bool Contains(uint32 comp_id) const
     {
@@ -216,11 +350,188 @@ struct Archetype
         uint32 comp_id = Component<C>::GetTypeID();
         return Description.Contains(comp_id);
     }
+
+    // Calls func(EntityHandle, Cs&...) for every entity, columns are resolved once per chunk.
+    // Non-const Cs count as writes and stamp the chunk columns with a new change version.
+    // Shared Cs must be const and refer to the archetype's value for every entity.
+    template <class... Cs, class F>
+    void Each(F&& func)
+    {
+        EachChanged<Cs...>(0, func);
+    }
+    // Same as Each, but skips chunks where none of Cs changed after since_version (0 visits every chunk)
+    template <class... Cs, class F>
+    void EachChanged(uint32 since_version, F&& func)
+    {
+        static_assert(((!IsSharedComponent<Cs>::value || std::is_const<Cs>::value) && ...), "Shared components are read only");
+
+        uint32 write_version = HasWriteAccess<Cs...>() ? NextChangeVersion() : 0;
+        uint32 columns[] = {GetEachColumn<Cs>()...};
+        for (ArchetypeChunk& chunk : Chunks)
+        {
+            EachInChunk<Cs...>(chunk, columns, since_version, write_version, func, std::index_sequence_for<Cs...>{});
+        }
+    }
+    template <class... Cs, class F>
+    void EachInChunk(ArchetypeChunk& chunk, uint32 since_version, uint32 write_version, F&& func)
+    {
+        static_assert(((!IsSharedComponent<Cs>::value || std::is_const<Cs>::value) && ...), "Shared components are read only");
+
+        uint32 columns[] = {GetEachColumn<Cs>()...};
+        EachInChunk<Cs...>(chunk, columns, since_version, write_version, func, std::index_sequence_for<Cs...>{});
+    }
+
+    template <class... Cs>
+    static constexpr bool HasWriteAccess()
+    {
+        return (!std::is_const<Cs>::value || ...);
+    }
+
+private:
+    // Column of C, or its component id if it is shared
+    template <class C>
+    uint32 GetEachColumn() const
+    {
+        uint32 comp_id = Component<C>::GetTypeID();
+        return IsSharedComponent<C>::value ? comp_id : GetColumn(comp_id);
+    }
+    template <class C>
+    C* GetEachData(uint32 column, ArchetypeChunk& chunk)
+    {
+        return (C*)(IsSharedComponent<C>::value ? GetSharedComponentData(column) : GetComponentData(column, chunk));
+    }
+    // Shared values never change in place, so they neither count as changed nor get stamped
+    template <class C>
+    static bool ColumnChanged(const ArchetypeChunk& chunk, uint32 column, uint32 since_version)
+    {
+        return !IsSharedComponent<C>::value && chunk.ColumnVersions[column] > since_version;
+    }
+    template <class C>
+    static void StampColumn(ArchetypeChunk& chunk, uint32 column, uint32 write_version)
+    {
+        if (!std::is_const<C>::value)
+        {
+            chunk.ColumnVersions[column] = write_version;
+        }
+    }
+
+    template <class... Cs, class F, size_t... I>
+    void EachInChunk(ArchetypeChunk& chunk, const uint32* columns, uint32 since_version, uint32 write_version, F& func, std::index_sequence<I...>)
+    {
+        if (since_version && !(ColumnChanged<Cs>(chunk, columns[I], since_version) || ...))
+        {
+            return;
+        }
+        if (write_version)
+        {
+            (StampColumn<Cs>(chunk, columns[I], write_version), ...);
+        }
+
+        EachInArrays(chunk.GetEntityHandles(), chunk.Count, func, GetEachData<Cs>(columns[I], chunk)...);
+    }
+
+    template <class C>
+    static C& GetElement(C* components, uint32 index)
+    {
+        return components[IsSharedComponent<C>::value ? 0 : index];
+    }
+
+    template <class F, class... Cs>
+    static void EachInArrays(EntityHandle* entities, uint32 count, F& func, Cs*... components)
+    {
+        for (uint32 i = 0; i < count; i++)
+        {
+            func(entities[i], GetElement(components, i)...);
+        }
+    }
+};
+
+// Archetypes matching a signature. Archetypes are never destroyed, so only
+// archetypes created since the last refresh need to be tested.
+struct QueryCache
+{
+    ComponentSignature Signature;
+    std::vector<Archetype*> Archetypes;
+    uint32 TestedArchetypeCount = 0;
+    // Owned by the registry
+    std::atomic<uint32>* ChangeVersion = nullptr;
+
+    void Refresh(const std::vector<Archetype*>& archetypes)
+    {
+        // Up to date caches are only read, so systems running concurrently can share them
+        if (TestedArchetypeCount == archetypes.size())
+        {
+            return;
+        }
+
+        for (uint32 i = TestedArchetypeCount; i < archetypes.size(); i++)
+        {
+            if (archetypes[i]->Description.ContainsAll(Signature))
+            {
+                Archetypes.push_back(archetypes[i]);
+            }
+        }
+        TestedArchetypeCount = archetypes.size();
+    }
+
+    template <class... Cs, class F>
+    void Each(F&& func)
+    {
+        EachChanged<Cs...>(0, func);
+    }
+
+    template <class... Cs, class F>
+    void EachChanged(uint32 since_version, F&& func)
+    {
+        for (Archetype* archetype : Archetypes)
+        {
+            archetype->EachChanged<Cs...>(since_version, func);
+        }
+    }
+
+    // Splits the matching chunks into batches across the job system threads and joins before returning.
+    // func runs concurrently, so it must not make structural changes to the registry. Per-thread
+    // storage is available through JobSystem::GetThreadIndex() and JobSystem::GetThreadScratch().
+    template <class... Cs, class F>
+    void ParallelEach(JobSystem* jobs, F&& func, uint32 since_version = 0)
+    {
+        uint32 write_version = Archetype::HasWriteAccess<Cs...>() ? ++(*ChangeVersion) : 0;
+
+        struct ChunkRef
+        {
+            Archetype* Owner;
+            ArchetypeChunk* Chunk;
+        };
+        std::vector<ChunkRef> chunks;
+        for (Archetype* archetype : Archetypes)
+        {
+            for (ArchetypeChunk& chunk : archetype->Chunks)
+            {
+                chunks.push_back({archetype, &chunk});
+            }
+        }
+
+        // A few batches per thread to even out uneven chunks
+        uint32 batch_count = jobs->GetThreadCount() * 4;
+        if (batch_count > chunks.size())
+        {
+            batch_count = chunks.size();
+        }
+
+        jobs->Dispatch(batch_count, [&](uint32 batch_index) {
+            uint32 begin = (uint64)chunks.size() * batch_index / batch_count;
+            uint32 end = (uint64)chunks.size() * (batch_index + 1) / batch_count;
+            for (uint32 i = begin; i < end; i++)
+            {
+                chunks[i].Owner->template EachInChunk<Cs...>(*chunks[i].Chunk, since_version, write_version, func);
+            }
+        });
+    }
 };
 
 struct EntityRegistry
 {
-    EntityHandleAllocator<8> m_HandleAllocator;
+    EntityHandleAllocator m_HandleAllocator;
     
     struct EntityRecord
     {
@@ -228,90 +539,236 @@ struct EntityRegistry
         uint32 Index;
     };
 
-    std::unordered_map<EntityHandle, EntityRecord> m_Entities;
+    // Indexed by entity slot
+    std::vector<EntityRecord> m_Entities;
     std::vector<Archetype*> m_Archetypes;
-    std::unordered_map<uint32, uint32> m_ComponentSizes;
-
-    void Advance()
+    // Indexed by component id, 0 if not registered
+    uint32 m_ComponentSizes[AR_ECS_MAX_COMPONENTS] = {};
+    // Indexed by component id, hash of the registered name, 0 if registered without a name.
+    // Component ids depend on first use order, snapshots refer to components by these instead.
+    uint64 m_ComponentStableIDs[AR_ECS_MAX_COMPONENTS] = {};
+
+    // Components registered as shared, see IsSharedComponent
+    ComponentSignature m_SharedComponents;
+
+    // Archetypes indexed by hashed signature
+    std::unordered_map<ComponentSignature, Archetype*> m_ArchetypeLookup;
+    // Archetypes with shared components, indexed by hashed signature and shared values
+    std::unordered_map<uint64, std::vector<Archetype*>> m_SharedArchetypeLookup;
+    // Add edges from entities without any components
+    std::unordered_map<uint32, Archetype*> m_RootAddEdges;
+
+    std::unordered_map<ComponentSignature, QueryCache> m_QueryCaches;
+    // Set while systems run concurrently, no query caches may be created then
+    bool m_QueryCachesLocked = false;
+
+    // Incremented for every write, chunk columns store the version of their last write.
+    // Atomic since systems may iterate concurrently, see SystemScheduler.
+    std::atomic<uint32> m_ChangeVersion = {0};
+
+    // Loaded snapshots, mapped chunks point into these
+    std::vector<MappedFile*> m_MappedFiles;
+
+    ~EntityRegistry()
     {
-        m_HandleAllocator.Advance();
+        for (Archetype* archetype : m_Archetypes)
+        {
+            archetype->CleanUp();
+            delete archetype;
+        }
+        m_Archetypes.clear();
+
+        for (MappedFile* file : m_MappedFiles)
+        {
+            delete file;
+        }
+        m_MappedFiles.clear();
     }
 
+    // Components registered with a name can be saved in snapshots, the name must stay the same between runs
     template<class C>
-    void RegisterComponent()
+    void RegisterComponent(const char* name = nullptr)
     {
         uint32 id = Component<C>::GetTypeID();
-        AR_CORE_ASSERT(m_ComponentSizes.find(id) == m_ComponentSizes.end(), "Tried registering component that was already registered");
+        AR_CORE_ASSERT(id < AR_ECS_MAX_COMPONENTS, "Tried registering more than %d components", AR_ECS_MAX_COMPONENTS);
+        AR_CORE_ASSERT(m_ComponentSizes[id] == 0, "Tried registering component that was already registered");
 
         m_ComponentSizes[id] = sizeof(C);
+        m_SharedComponents.set(id, IsSharedComponent<C>::value);
+
+        if (name)
+        {
+            Hasher hasher;
+            hasher.data(name, strlen(name));
+            m_ComponentStableIDs[id] = hasher.GetHash();
+            AR_CORE_ASSERT(m_ComponentStableIDs[id] != 0, "Component name %s hashes to 0", name);
+        }
+    }
+
+    // Component id registered with the stable id, -1 if none
+    int32 FindComponent(uint64 stable_id) const
+    {
+        for (uint32 id = 0; id < AR_ECS_MAX_COMPONENTS; id++)
+        {
+            if (stable_id && m_ComponentStableIDs[id] == stable_id)
+            {
+                return id;
+            }
+        }
+        return -1;
     }
 
     EntityHandle CreateEntity()
     {
         EntityHandle result = m_HandleAllocator.Allocate();
-        m_Entities.insert({result, {nullptr, 0}});
+        if (result.GetIndex() >= m_Entities.size())
+        {
+            m_Entities.resize(result.GetIndex() + 1);
+        }
+        m_Entities[result.GetIndex()] = {nullptr, 0};
         return result;
     }
 
+    // Creates count entities directly in the archetype of Cs, components are default constructed
+    template <class... Cs>
+    std::vector<EntityHandle> CreateEntities(uint32 count)
+    {
+        return CreateEntitiesInternal<Cs...>(count, ((const Cs*)nullptr)...);
+    }
+
+    // Creates count entities directly in the archetype of Cs, components are copy constructed from the prototypes
+    template <class... Cs>
+    std::vector<EntityHandle> CreateEntities(uint32 count, const Cs&... prototypes)
+    {
+        return CreateEntitiesInternal<Cs...>(count, &prototypes...);
+    }
+
     void DestroyEntity(EntityHandle entity)
     {
-        AR_CORE_ASSERT(m_Entities.find(entity) != m_Entities.end(), "Tried destroying invalid entity");
+        AR_CORE_ASSERT(IsAlive(entity), "Tried destroying invalid entity");
         
-        EntityRecord record = m_Entities[entity];
+        EntityRecord record = m_Entities[entity.GetIndex()];
+
+        if (record.Archetype)
+        {
+            EntityHandle moved_entity;
+            if (record.Archetype->RemoveEntity(record.Index, moved_entity))
+            {
+                m_Entities[moved_entity.GetIndex()].Index = record.Index;
+            }
+        }
 
-        uint32 back_index = record.Archetype->EntityHandles.size() - 1;
-        // Swap and pop
-        EntityHandle back_entity = record.Archetype->EntityHandles.back();
-        record.Archetype->EntityHandles[record.Index] = back_entity;
-        record.Archetype->EntityHandles.pop_back();
+        m_Entities[entity.GetIndex()] = {nullptr, 0};
+        m_HandleAllocator.Release(entity);
+    }
 
-        m_Entities[back_entity].Index = record.Index;
+    bool IsAlive(EntityHandle entity) const
+    {
+        return m_HandleAllocator.IsAlive(entity);
+    }
 
-        for (auto& comp_id : record.Archetype->Description.ComponentTypes)
+    template <class... Cs>
+    static ComponentSignature GetSignature()
+    {
+        ComponentSignature signature;
+        (signature.set(Component<Cs>::GetTypeID()), ...);
+        return signature;
+    }
+
+    QueryCache* RequestQueryCache(const ComponentSignature& signature)
+    {
+        auto find = m_QueryCaches.find(signature);
+        if (find == m_QueryCaches.end())
         {
-            uint32 comp_size = m_ComponentSizes[comp_id];
-            std::vector<uint8>& data = record.Archetype->GetComponentData(comp_id);
+            AR_CORE_ASSERT(!m_QueryCachesLocked, "Tried creating query cache while systems are running, create a Query before");
 
-            memcpy(&data[record.Index * comp_size], &data[back_index * comp_size], comp_size);
-            data.resize(back_index * comp_size);
+            find = m_QueryCaches.try_emplace(signature).first;
+            find->second.Signature = signature;
+            find->second.ChangeVersion = &m_ChangeVersion;
         }
+        find->second.Refresh(m_Archetypes);
+        return &find->second;
+    }
 
-        m_Entities.erase(entity);
-        m_HandleAllocator.Release(entity);
+    // Brings every query up to date with the archetypes, after which requesting and refreshing existing queries only
+    // reads shared state, as long as no archetypes are created
+    void RefreshQueryCaches()
+    {
+        for (auto& [signature, cache] : m_QueryCaches)
+        {
+            cache.Refresh(m_Archetypes);
+        }
+    }
+    // See SystemScheduler::Run
+    void LockQueryCaches(bool locked)
+    {
+        m_QueryCachesLocked = locked;
     }
 
-    template <class C>
-    void getid(std::set<uint32>& ids)
+    // Calls func(EntityHandle, Cs&...) for every entity that has all of Cs
+    template <class... Cs, class F>
+    void Each(F&& func)
     {
-        ids.insert(Component<C>::GetTypeID());
+        static_assert(sizeof...(Cs) > 0, "Each requires at least one component");
+
+        RequestQueryCache(GetSignature<Cs...>())->template Each<Cs...>(func);
     }
 
-    template <class First, class Second, class... Rest>
-    void getid(std::set<uint32>& ids)
+    // Each, only visiting chunks where any of Cs changed after since_version
+    template <class... Cs, class F>
+    void EachChanged(uint32 since_version, F&& func)
     {
-        getid<First>(ids);
-        getid<Second, Rest...>(ids);
+        static_assert(sizeof...(Cs) > 0, "EachChanged requires at least one component");
+
+        RequestQueryCache(GetSignature<Cs...>())->template EachChanged<Cs...>(since_version, func);
+    }
+
+    // Bytes allocated for entity records and archetype chunks, mapped snapshot chunks are not included
+    uint64 GetMemoryUsage() const
+    {
+        uint64 bytes = m_Entities.capacity() * sizeof(EntityRecord);
+        for (const Archetype* archetype : m_Archetypes)
+        {
+            bytes += archetype->Chunks.capacity() * sizeof(ArchetypeChunk);
+            for (const ArchetypeChunk& chunk : archetype->Chunks)
+            {
+                bytes += chunk.Mapped ? 0 : archetype->ChunkSize;
+            }
+        }
+        return bytes;
+    }
+
+    uint32 GetChangeVersion() const { return m_ChangeVersion.load(); }
+    // For systems writing component memory directly, stamp written columns with the returned version
+    uint32 NextChangeVersion() { return ++m_ChangeVersion; }
+
+    // Parallel Each, see QueryCache::ParallelEach
+    template <class... Cs, class F>
+    void ParallelEach(JobSystem* jobs, F&& func, uint32 since_version = 0)
+    {
+        static_assert(sizeof...(Cs) > 0, "ParallelEach requires at least one component");
+
+        RequestQueryCache(GetSignature<Cs...>())->template ParallelEach<Cs...>(jobs, func, since_version);
     }
 
     template<class C, class... Cs>
     std::vector<EntityHandle> GetEntitiesWith()
     {
-        std::set<uint32> ids;
-        getid<C, Cs...>(ids);
+        ComponentSignature signature = GetSignature<C, Cs...>();
 
         std::vector<EntityHandle> result;
         
         for (auto& archetype : m_Archetypes)
         {
-            for (auto& id : ids)
+            if (!archetype->Description.ContainsAll(signature))
             {
-                if (!archetype->Description.Contains(id))
-                {
-                    break;
-                }
+                continue;
             }
 
-            result.insert(result.begin(), archetype->EntityHandles.begin(), archetype->EntityHandles.end());
+            for (ArchetypeChunk& chunk : archetype->Chunks)
+            {
+                result.insert(result.end(), chunk.GetEntityHandles(), chunk.GetEntityHandles() + chunk.Count);
+            }
         }
 
         return result;
@@ -319,22 +776,16 @@ struct EntityRegistry
     template<class A, class... As>
     std::vector<Archetype*> GetArchetypesWith()
     {
-        std::set<uint32> ids;
-        getid<A, As...>(ids);
+        ComponentSignature signature = GetSignature<A, As...>();
 
         std::vector<Archetype*> result;
         
         for (Archetype* archetype : m_Archetypes)
         {
-            for (auto& id : ids)
+            if (archetype->Description.ContainsAll(signature))
             {
-                if (!archetype->Description.Contains(id))
-                {
-                    break;
-                }
+                result.push_back(archetype);
             }
-
-            result.push_back(archetype);
         }
 
         return result;
@@ -346,7 +797,10 @@ struct EntityRegistry
 
         for (auto& archetype : m_Archetypes)
         {
-            result.insert(result.begin(), archetype->EntityHandles.begin(), archetype->EntityHandles.end());
+            for (ArchetypeChunk& chunk : archetype->Chunks)
+            {
+                result.insert(result.end(), chunk.GetEntityHandles(), chunk.GetEntityHandles() + chunk.Count);
+            }
         }
 
         return result;
@@ -356,206 +810,472 @@ struct EntityRegistry
     C* GetComponent(EntityHandle entity)
     {
         uint32 id = Component<C>::GetTypeID();
-        AR_CORE_ASSERT(m_ComponentSizes.find(id) != m_ComponentSizes.end(), "Tried getting component that has not been registered");
-        uint32 size = m_ComponentSizes[id];
+        AR_CORE_ASSERT(m_ComponentSizes[id], "Tried getting component that has not been registered");
+        AR_CORE_ASSERT(IsAlive(entity), "Tried getting component of invalid entity");
+
+        EntityRecord record = m_Entities[entity.GetIndex()];
+        if constexpr (IsSharedComponent<C>::value)
+        {
+            static_assert(std::is_const<C>::value, "Shared components are read only, use SetSharedComponent");
+            return (C*)record.Archetype->GetSharedComponentData(id);
+        }
 
-        EntityRecord record = m_Entities[entity];
-        return (C*)&record.Archetype->GetComponentData(id)[record.Index * size];
+        uint32 column = record.Archetype->GetColumn(id);
+        if (!std::is_const<C>::value)
+        {
+            record.Archetype->MarkChanged(column, record.Index);
+        }
+        return (C*)record.Archetype->GetComponentData(column, record.Index);
     }
 
     template <class C>
     void RemoveComponent(EntityHandle entity)
     {
         uint32 id = Component<C>::GetTypeID();
-        AR_CORE_ASSERT(m_ComponentSizes.find(id) != m_ComponentSizes.end(), "Tried removing component that has not been registered");
-        uint32 size = m_ComponentSizes[id];
+        AR_CORE_ASSERT(m_ComponentSizes[id], "Tried removing component that has not been registered");
+        AR_CORE_ASSERT(IsAlive(entity), "Tried removing component of invalid entity");
+
+        EntityRecord old_record = m_Entities[entity.GetIndex()];
+        AR_CORE_ASSERT(old_record.Archetype && old_record.Archetype->Contains(id), "Tried removing component that entity does not have");
+
+        Archetype* new_archetype = GetRemoveTransition(old_record.Archetype, id);
+        MoveEntity(entity, new_archetype);
+    }
+    
+    template <class C, typename... Args>
+    void AddComponent(EntityHandle entity, Args&&... args)
+    {
+        uint32 id = Component<C>::GetTypeID();
+        AR_CORE_ASSERT(m_ComponentSizes[id], "Tried adding component that has not been registered");
 
-        EntityRecord old_record = m_Entities[entity];
-        AR_CORE_ASSERT(old_record.Archetype->Contains(id), "Tried getting component that has not been registered");
+        if constexpr (IsSharedComponent<C>::value)
+        {
+            AddComponent<C>(entity, C(std::forward<Args>(args)...));
+        }
+        else
+        {
+            new (AddComponentInternal(entity, id)) C(std::forward<Args>(args)...);
+        }
+    }
 
-        ArchetypeDescription arch_desc = old_record.Archetype->Description;
-        arch_desc.ComponentTypes.erase(id);
+    template <class C>
+    void AddComponent(EntityHandle entity, C component)
+    {
+        uint32 id = Component<C>::GetTypeID();
+        AR_CORE_ASSERT(m_ComponentSizes[id], "Tried adding component that has not been registered");
+
+        if constexpr (IsSharedComponent<C>::value)
+        {
+            AR_CORE_ASSERT(IsAlive(entity), "Tried adding component to invalid entity");
+            AR_CORE_ASSERT(!GetArchetype(entity) || !GetArchetype(entity)->Contains(id), "Tried adding component that entity already has");
+            SetSharedComponent<C>(entity, component);
+        }
+        else
+        {
+            new (AddComponentInternal(entity, id)) C(component);
+        }
+    }
+
+    // Adds or replaces a shared component, moves the entity to the archetype holding the value
+    template <class C>
+    void SetSharedComponent(EntityHandle entity, const C& value)
+    {
+        static_assert(IsSharedComponent<C>::value, "SetSharedComponent requires a shared component");
 
-        EntityRecord new_record;
-        new_record.Archetype = RequestArchetype(arch_desc);
-        new_record.Index = new_record.Archetype->EntityHandles.size();
-        new_record.Archetype->EntityHandles.push_back(entity);
+        uint32 id = Component<C>::GetTypeID();
+        AR_CORE_ASSERT(m_ComponentSizes[id], "Tried setting component that has not been registered");
+        AR_CORE_ASSERT(IsAlive(entity), "Tried setting component of invalid entity");
 
-        uint32 old_back_index = old_record.Archetype->EntityHandles.size() - 1;
-        // Swap and pop
-        EntityHandle old_back_entity = old_record.Archetype->EntityHandles.back();
-        old_record.Archetype->EntityHandles[old_record.Index] = old_back_entity;
-        old_record.Archetype->EntityHandles.pop_back();
+        Archetype* old_archetype = m_Entities[entity.GetIndex()].Archetype;
 
-        m_Entities[old_back_entity].Index = old_record.Index;
+        ArchetypeDescription desc;
+        if (old_archetype)
+        {
+            desc = old_archetype->Description;
+        }
+        desc.Add(id);
 
-        for (auto& comp_id : old_record.Archetype->Description.ComponentTypes)
+        std::vector<uint8> shared_data = BuildSharedData(old_archetype, desc.Signature, id, &value);
+        Archetype* new_archetype = RequestArchetype(desc, shared_data.data());
+        if (new_archetype != old_archetype)
         {
-            uint32 comp_size = m_ComponentSizes[comp_id];
-            std::vector<uint8>& old_data = old_record.Archetype->GetComponentData(comp_id);
+            MoveEntity(entity, new_archetype);
+        }
+    }
 
-            if (comp_id != id)
+    // shared_data holds the values of the shared components in desc, see Archetype::GetSharedLayout
+    Archetype* RequestArchetype(const ArchetypeDescription& desc, const uint8* shared_data = nullptr)
+    {
+        ComponentSignature shared_components = desc.Signature & m_SharedComponents;
+        if (shared_components.none())
+        {
+            auto find = m_ArchetypeLookup.find(desc.Signature);
+            if (find != m_ArchetypeLookup.end())
             {
-                std::vector<uint8>& new_data = new_record.Archetype->GetComponentData(comp_id);
-                new_data.resize((new_record.Index + 1) * size);
-                memcpy(&new_data[new_record.Index * comp_size], &old_data[old_record.Index * comp_size], comp_size);
+                return find->second;
             }
 
-            memcpy(&old_data[old_record.Index * comp_size], &old_data[old_back_index * comp_size], comp_size);
-            old_data.resize(old_back_index * comp_size);
+            Archetype* archetype = new Archetype();
+            archetype->Init(desc, m_ComponentSizes, m_SharedComponents, nullptr, &m_ChangeVersion);
+            m_Archetypes.push_back(archetype);
+            m_ArchetypeLookup[desc.Signature] = archetype;
+
+            return archetype;
         }
 
-        m_Entities[entity] = new_record;
+        AR_CORE_ASSERT(shared_data, "Tried requesting archetype with shared components without their values");
+
+        int32 offsets[AR_ECS_MAX_COMPONENTS];
+        uint32 shared_size = Archetype::GetSharedLayout(shared_components, m_ComponentSizes, offsets);
+
+        Hasher hasher(std::hash<ComponentSignature>()(desc.Signature));
+        hasher.data(shared_data, shared_size);
+
+        std::vector<Archetype*>& bucket = m_SharedArchetypeLookup[hasher.GetHash()];
+        for (Archetype* archetype : bucket)
+        {
+            if (archetype->Description.Signature == desc.Signature && memcmp(archetype->SharedData.data(), shared_data, shared_size) == 0)
+            {
+                return archetype;
+            }
+        }
+
+        Archetype* archetype = new Archetype();
+        archetype->Init(desc, m_ComponentSizes, m_SharedComponents, shared_data, &m_ChangeVersion);
+        m_Archetypes.push_back(archetype);
+        bucket.push_back(archetype);
+
+        return archetype;
     }
-    
-    template <class C, typename... Args>
-    void AddComponent(EntityHandle entity, Args&&... args)
+
+    // Shared values for an entity of archetype (or none) ending up with shared_components.
+    // Values are taken from archetype, except for id which is set to value (if not nullptr).
+    std::vector<uint8> BuildSharedData(Archetype* archetype, const ComponentSignature& signature, uint32 id, const void* value)
     {
-        uint32 id = Component<C>::GetTypeID();
-        AR_CORE_ASSERT(m_ComponentSizes.find(id) != m_ComponentSizes.end(), "Tried adding component that has not been registered");
-        uint32 size = m_ComponentSizes[id];
+        int32 offsets[AR_ECS_MAX_COMPONENTS];
+        std::vector<uint8> result(Archetype::GetSharedLayout(signature & m_SharedComponents, m_ComponentSizes, offsets));
 
-        EntityRecord old_record = m_Entities[entity];
+        for (uint32 i = 0; i < AR_ECS_MAX_COMPONENTS; i++)
+        {
+            if (offsets[i] < 0)
+            {
+                continue;
+            }
 
-        C* component = nullptr;
+            const void* src = i == id && value ? value : archetype->GetSharedComponentData(i);
+            memcpy(result.data() + offsets[i], src, m_ComponentSizes[i]);
+        }
 
-        if (old_record.Archetype)
+        return result;
+    }
+
+    Archetype* GetAddTransition(Archetype* archetype, uint32 id)
+    {
+        AR_CORE_ASSERT(!m_SharedComponents.test(id), "Shared components are added with SetSharedComponent");
+
+        std::unordered_map<uint32, Archetype*>& edges = archetype ? archetype->AddEdges : m_RootAddEdges;
+
+        auto find = edges.find(id);
+        if (find != edges.end())
         {
-            ArchetypeDescription arch_desc = old_record.Archetype->Description;
-            arch_desc.ComponentTypes.insert(id);
+            return find->second;
+        }
 
-            EntityRecord new_record;
-            new_record.Archetype = RequestArchetype(arch_desc);
-            new_record.Index = new_record.Archetype->EntityHandles.size();
-            new_record.Archetype->EntityHandles.push_back(entity);
+        ArchetypeDescription desc;
+        if (archetype)
+        {
+            desc = archetype->Description;
+        }
+        desc.Add(id);
 
-            uint32 old_back_index = old_record.Archetype->EntityHandles.size() - 1;
-            // Swap and pop
-            EntityHandle old_back_entity = old_record.Archetype->EntityHandles.back();
-            old_record.Archetype->EntityHandles[old_record.Index] = old_back_entity;
-            old_record.Archetype->EntityHandles.pop_back();
+        // Shared components are unchanged, so are their values
+        Archetype* result = RequestArchetype(desc, archetype ? archetype->SharedData.data() : nullptr);
+        edges[id] = result;
+        result->RemoveEdges[id] = archetype;
 
-            m_Entities[old_back_entity].Index = old_record.Index;
+        return result;
+    }
 
-            for (auto& comp_id : old_record.Archetype->Description.ComponentTypes)
-            {
-                uint32 comp_size = m_ComponentSizes[comp_id];
-                std::vector<uint8>& old_data = old_record.Archetype->GetComponentData(comp_id);
-                std::vector<uint8>& new_data = new_record.Archetype->GetComponentData(comp_id);
+    Archetype* GetRemoveTransition(Archetype* archetype, uint32 id)
+    {
+        auto find = archetype->RemoveEdges.find(id);
+        if (find != archetype->RemoveEdges.end())
+        {
+            return find->second;
+        }
 
-                new_data.resize((new_record.Index + 1) * size);
-                memcpy(&new_data[new_record.Index * comp_size], &old_data[old_record.Index * comp_size], comp_size);
+        ArchetypeDescription desc = archetype->Description;
+        desc.Remove(id);
 
-                memcpy(&old_data[old_record.Index * comp_size], &old_data[old_back_index * comp_size], comp_size);
-                old_data.resize(old_back_index * comp_size);
-            }
+        std::vector<uint8> shared_data = BuildSharedData(archetype, desc.Signature, id, nullptr);
+        Archetype* result = desc.Empty() ? nullptr : RequestArchetype(desc, shared_data.data());
+        archetype->RemoveEdges[id] = result;
 
-            std::vector<uint8>& new_data = new_record.Archetype->GetComponentData(id);
-            new_data.resize((new_record.Index + 1) * size);
-            component = new (&new_data[new_record.Index * size]) C(std::forward<Args>(args)...);
+        // Adding a shared component back depends on its value
+        if (m_SharedComponents.test(id))
+        {
+            return result;
+        }
 
-            m_Entities[entity] = new_record;
+        if (result)
+        {
+            result->AddEdges[id] = archetype;
         }
         else
         {
-            ArchetypeDescription arch_desc;
-            arch_desc.ComponentTypes.insert(id);
+            m_RootAddEdges[id] = archetype;
+        }
 
-            EntityRecord new_record;
-            new_record.Archetype = RequestArchetype(arch_desc);
-            new_record.Index = new_record.Archetype->EntityHandles.size();
-            new_record.Archetype->EntityHandles.push_back(entity);
+        return result;
+    }
 
-            std::vector<uint8>& new_data = new_record.Archetype->GetComponentData(id);
-            new_data.resize((new_record.Index + 1) * size);
-            component = new (&new_data[new_record.Index * size]) C(std::forward<Args>(args)...);
+    // Moves entities that are all in src (or in no archetype if src is nullptr) to dst (or none).
+    // Entities with consecutive indices in src are copied as one run per column.
+    void MoveEntities(Archetype* src, Archetype* dst, std::vector<EntityHandle>& entities)
+    {
+        if (entities.empty() || src == dst)
+        {
+            return;
+        }
+
+        std::sort(entities.begin(), entities.end(), [this](const EntityHandle& a, const EntityHandle& b) {
+            return m_Entities[a.GetIndex()].Index < m_Entities[b.GetIndex()].Index;
+        });
 
-            m_Entities[entity] = new_record;
+        if (dst)
+        {
+            uint32 dst_index = dst->PushEntities(entities.data(), entities.size());
+
+            uint32 run_begin = 0;
+            for (uint32 i = 0; i < entities.size(); i++)
+            {
+                EntityRecord& record = m_Entities[entities[i].GetIndex()];
+                AR_CORE_ASSERT(record.Archetype == src, "Tried moving entity that is not in source archetype");
+
+                bool run_ends = i + 1 == entities.size() || m_Entities[entities[i + 1].GetIndex()].Index != record.Index + 1;
+                if (src && run_ends)
+                {
+                    uint32 run_src_index = m_Entities[entities[run_begin].GetIndex()].Index;
+                    Archetype::CopyComponents(src, run_src_index, dst, dst_index + run_begin, i + 1 - run_begin);
+                    run_begin = i + 1;
+                }
+            }
+        }
+
+        if (src)
+        {
+            // Remove back to front, so swapped in entities are never ones still waiting to be removed
+            for (int32 i = entities.size() - 1; i >= 0; i--)
+            {
+                EntityHandle moved_entity;
+                uint32 index = m_Entities[entities[i].GetIndex()].Index;
+                if (src->RemoveEntity(index, moved_entity))
+                {
+                    m_Entities[moved_entity.GetIndex()].Index = index;
+                }
+            }
+        }
+
+        uint32 dst_index = dst ? dst->EntityCount - entities.size() : 0;
+        for (uint32 i = 0; i < entities.size(); i++)
+        {
+            m_Entities[entities[i].GetIndex()] = {dst, dst ? dst_index + i : 0};
         }
     }
 
-    template <class C>
-    void AddComponent(EntityHandle entity, C component)
+    Archetype* GetArchetype(EntityHandle entity)
     {
-        uint32 id = Component<C>::GetTypeID();
-        AR_CORE_ASSERT(m_ComponentSizes.find(id) != m_ComponentSizes.end(), "Tried adding component that has not been registered");
-        uint32 size = m_ComponentSizes[id];
+        AR_CORE_ASSERT(IsAlive(entity), "Tried getting archetype of invalid entity");
+        return m_Entities[entity.GetIndex()].Archetype;
+    }
+    uint32 GetArchetypeIndex(EntityHandle entity)
+    {
+        AR_CORE_ASSERT(IsAlive(entity), "Tried getting archetype index of invalid entity");
+        return m_Entities[entity.GetIndex()].Index;
+    }
 
-        EntityRecord old_record = m_Entities[entity];
+private:
+    // Moves the entity and the components it keeps to a new archetype (or none), returns the new record.
+    // Components that do not exist in the old archetype are left uninitialized.
+    EntityRecord MoveEntity(EntityHandle entity, Archetype* new_archetype)
+    {
+        EntityRecord& record = m_Entities[entity.GetIndex()];
+        EntityRecord old_record = record;
 
+        EntityRecord new_record = {new_archetype, 0};
+
+        if (new_archetype)
+        {
+            new_record.Index = new_archetype->PushEntity(entity);
+        }
 
         if (old_record.Archetype)
         {
-            ArchetypeDescription arch_desc = old_record.Archetype->Description;
-            arch_desc.ComponentTypes.insert(id);
+            Archetype* old_archetype = old_record.Archetype;
 
-            EntityRecord new_record;
-            new_record.Archetype = RequestArchetype(arch_desc);
-            new_record.Index = new_record.Archetype->EntityHandles.size();
-            new_record.Archetype->EntityHandles.push_back(entity);
+            if (new_archetype)
+            {
+                Archetype::CopyComponents(old_archetype, old_record.Index, new_archetype, new_record.Index, 1);
+            }
 
-            uint32 old_back_index = old_record.Archetype->EntityHandles.size() - 1;
-            // Swap and pop
-            EntityHandle old_back_entity = old_record.Archetype->EntityHandles.back();
-            old_record.Archetype->EntityHandles[old_record.Index] = old_back_entity;
-            old_record.Archetype->EntityHandles.pop_back();
+            EntityHandle moved_entity;
+            if (old_archetype->RemoveEntity(old_record.Index, moved_entity))
+            {
+                m_Entities[moved_entity.GetIndex()].Index = old_record.Index;
+            }
+        }
 
-            m_Entities[old_back_entity].Index = old_record.Index;
+        record = new_record;
 
-            for (auto& comp_id : old_record.Archetype->Description.ComponentTypes)
-            {
-                uint32 comp_size = m_ComponentSizes[comp_id];
-                std::vector<uint8>& old_data = old_record.Archetype->GetComponentData(comp_id);
-                std::vector<uint8>& new_data = new_record.Archetype->GetComponentData(comp_id);
+        return new_record;
+    }
 
-                new_data.resize((new_record.Index + 1) * size);
-                memcpy(&new_data[new_record.Index * comp_size], &old_data[old_record.Index * comp_size], comp_size);
+    template <class... Cs>
+    std::vector<EntityHandle> CreateEntitiesInternal(uint32 count, const Cs*... prototypes)
+    {
+        static_assert(sizeof...(Cs) > 0, "CreateEntities requires at least one component");
 
-                memcpy(&old_data[old_record.Index * comp_size], &old_data[old_back_index * comp_size], comp_size);
-                old_data.resize(old_back_index * comp_size);
-            }
+        ComponentSignature signature = GetSignature<Cs...>();
+        for (uint32 id = 0; id < AR_ECS_MAX_COMPONENTS; id++)
+        {
+            AR_CORE_ASSERT(!signature.test(id) || m_ComponentSizes[id], "Tried creating entities with component that has not been registered");
+        }
+
+        ArchetypeDescription desc;
+        desc.Signature = signature;
+
+        int32 shared_offsets[AR_ECS_MAX_COMPONENTS];
+        std::vector<uint8> shared_data(Archetype::GetSharedLayout(signature & m_SharedComponents, m_ComponentSizes, shared_offsets));
+        (ConstructSharedComponent<Cs>(shared_data.data(), shared_offsets, prototypes), ...);
 
-            std::vector<uint8>& new_data = new_record.Archetype->GetComponentData(id);
-            new_data.resize((new_record.Index + 1) * size);
-            C comp = component;
-            memcpy(&new_data[new_record.Index * size], &comp, size);
+        Archetype* archetype = RequestArchetype(desc, shared_data.data());
 
-            m_Entities[entity] = new_record;
+        std::vector<EntityHandle> result(count);
+        for (uint32 i = 0; i < count; i++)
+        {
+            result[i] = m_HandleAllocator.Allocate();
         }
-        else
+        m_Entities.resize(m_HandleAllocator.GetCapacity());
+
+        archetype->Reserve(count);
+        uint32 first_index = archetype->PushEntities(result.data(), count);
+        for (uint32 i = 0; i < count; i++)
         {
-            ArchetypeDescription arch_desc;
-            arch_desc.ComponentTypes.insert(id);
+            m_Entities[result[i].GetIndex()] = {archetype, first_index + i};
+        }
 
-            EntityRecord new_record;
-            new_record.Archetype = RequestArchetype(arch_desc);
-            new_record.Index = new_record.Archetype->EntityHandles.size();
-            new_record.Archetype->EntityHandles.push_back(entity);
+        (ConstructComponents<Cs>(archetype, first_index, count, prototypes), ...);
 
-            std::vector<uint8>& new_data = new_record.Archetype->GetComponentData(id);
-            new_data.resize((new_record.Index + 1) * size);
-            C comp = component;
-            memcpy(&new_data[new_record.Index * size], &comp, size);
+        return result;
+    }
 
-            m_Entities[entity] = new_record;
+    template <class C>
+    static void ConstructSharedComponent(uint8* shared_data, const int32* shared_offsets, const C* prototype)
+    {
+        if constexpr (IsSharedComponent<C>::value)
+        {
+            uint8* value = shared_data + shared_offsets[Component<C>::GetTypeID()];
+            prototype ? new (value) C(*prototype) : new (value) C();
         }
     }
 
-    Archetype* RequestArchetype(const ArchetypeDescription& desc)
+    // Constructs one column at a time, in runs that stay within a chunk
+    template <class C>
+    static void ConstructComponents(Archetype* archetype, uint32 first_index, uint32 count, const C* prototype)
     {
-        for (Archetype* arch : m_Archetypes)
+        if constexpr (IsSharedComponent<C>::value)
         {
-            if (arch->Description.ComponentTypes == desc.ComponentTypes)
+            return;
+        }
+
+        uint32 column = archetype->GetColumn(Component<C>::GetTypeID());
+        uint32 end_index = first_index + count;
+
+        for (uint32 index = first_index; index < end_index;)
+        {
+            uint32 run = archetype->ChunkCapacity - index % archetype->ChunkCapacity;
+            run = run < end_index - index ? run : end_index - index;
+
+            C* components = (C*)archetype->GetComponentData(column, index);
+            if (prototype)
             {
-                return arch;
+                for (uint32 i = 0; i < run; i++)
+                {
+                    new (&components[i]) C(*prototype);
+                }
+            }
+            else
+            {
+                for (uint32 i = 0; i < run; i++)
+                {
+                    new (&components[i]) C();
+                }
             }
+
+            index += run;
         }
+    }
 
-        Archetype* archetype = new Archetype();
-        archetype->Description = desc;
-        m_Archetypes.push_back(archetype);
-        archetype->ComponentData.resize(desc.ComponentTypes.size(), {});
+    uint8* AddComponentInternal(EntityHandle entity, uint32 id)
+    {
+        AR_CORE_ASSERT(IsAlive(entity), "Tried adding component to invalid entity");
 
-        return archetype;
+        EntityRecord old_record = m_Entities[entity.GetIndex()];
+
+        AR_CORE_ASSERT(!old_record.Archetype || !old_record.Archetype->Contains(id), "Tried adding component that entity already has");
+
+        EntityRecord new_record = MoveEntity(entity, GetAddTransition(old_record.Archetype, id));
+
+        return new_record.Archetype->GetComponentData(new_record.Archetype->GetColumn(id), new_record.Index);
     }
 };
+
+// Persistent query over the archetypes matching all of its components
+template <class... Cs>
+class Query
+{
+private:
+    EntityRegistry* m_Registry = nullptr;
+    // Owned by the registry, pointers into its cache map stay valid
+    QueryCache* m_Cache = nullptr;
+
+public:
+    Query() = default;
+    Query(EntityRegistry* registry)
+    {
+        Init(registry);
+    }
+
+    void Init(EntityRegistry* registry)
+    {
+        m_Registry = registry;
+        m_Cache = registry->RequestQueryCache(EntityRegistry::GetSignature<Cs...>());
+    }
+
+    const std::vector<Archetype*>& GetArchetypes()
+    {
+        m_Cache->Refresh(m_Registry->m_Archetypes);
+        return m_Cache->Archetypes;
+    }
+
+    template <class F>
+    void Each(F&& func)
+    {
+        m_Cache->Refresh(m_Registry->m_Archetypes);
+        m_Cache->Each<Cs...>(func);
+    }
+
+    template <class F>
+    void EachChanged(uint32 since_version, F&& func)
+    {
+        m_Cache->Refresh(m_Registry->m_Archetypes);
+        m_Cache->EachChanged<Cs...>(since_version, func);
+    }
+
+    template <class F>
+    void ParallelEach(JobSystem* jobs, F&& func, uint32 since_version = 0)
+    {
+        m_Cache->Refresh(m_Registry->m_Archetypes);
+        m_Cache->ParallelEach<Cs...>(jobs, func, since_version);
+    }
+};
\ No newline at end of file
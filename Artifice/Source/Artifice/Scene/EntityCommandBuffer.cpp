@@ -0,0 +1,147 @@
+#include "EntityCommandBuffer.h"
+
+#include <map>
+
+#include "Artifice/Debug/Instrumentor.h"
+
+
+void EntityCommandBuffer::Playback()
+{
+    AR_PROFILE_FUNCTION();
+
+    struct PendingEntity
+    {
+        EntityHandle Entity;
+        ComponentSignature Signature;
+        bool Destroyed = false;
+        // Last recorded value per component, -1 if none
+        int32 DataOffsets[AR_ECS_MAX_COMPONENTS];
+    };
+
+    // Fold commands per entity
+    std::vector<PendingEntity> pending;
+    std::unordered_map<EntityHandle, uint32> pending_lookup;
+
+    for (Command& command : m_Commands)
+    {
+        if (!m_Registry->IsAlive(command.Entity))
+        {
+            AR_CORE_WARN("EntityCommandBuffer command for invalid entity");
+            continue;
+        }
+
+        auto find = pending_lookup.find(command.Entity);
+        if (find == pending_lookup.end())
+        {
+            Archetype* archetype = m_Registry->GetArchetype(command.Entity);
+
+            PendingEntity entity;
+            entity.Entity = command.Entity;
+            entity.Signature = archetype ? archetype->Description.Signature : ComponentSignature();
+            for (uint32 i = 0; i < AR_ECS_MAX_COMPONENTS; i++)
+            {
+                entity.DataOffsets[i] = -1;
+            }
+
+            find = pending_lookup.insert({command.Entity, (uint32)pending.size()}).first;
+            pending.push_back(entity);
+        }
+
+        PendingEntity& entity = pending[find->second];
+        switch (command.Type)
+        {
+        case CommandType::Destroy:
+            entity.Destroyed = true;
+            break;
+        case CommandType::AddComponent:
+            entity.Signature.set(command.ComponentID);
+            entity.DataOffsets[command.ComponentID] = command.DataOffset;
+            break;
+        case CommandType::RemoveComponent:
+            entity.Signature.reset(command.ComponentID);
+            entity.DataOffsets[command.ComponentID] = -1;
+            break;
+        }
+    }
+
+    // Destroys first, they shuffle indices of the remaining entities
+    for (PendingEntity& entity : pending)
+    {
+        if (entity.Destroyed)
+        {
+            m_Registry->DestroyEntity(entity.Entity);
+        }
+    }
+
+    // Group migrations by (source, destination)
+    std::map<std::pair<Archetype*, Archetype*>, std::vector<EntityHandle>> moves;
+    for (PendingEntity& entity : pending)
+    {
+        if (entity.Destroyed)
+        {
+            continue;
+        }
+
+        Archetype* src = m_Registry->GetArchetype(entity.Entity);
+        Archetype* dst = nullptr;
+        if (entity.Signature.any())
+        {
+            ArchetypeDescription desc;
+            desc.Signature = entity.Signature;
+
+            // Shared values come from this buffer if added here, otherwise from the current archetype
+            int32 shared_offsets[AR_ECS_MAX_COMPONENTS];
+            std::vector<uint8> shared_data(Archetype::GetSharedLayout(entity.Signature & m_Registry->m_SharedComponents, m_Registry->m_ComponentSizes, shared_offsets));
+            for (uint32 id = 0; id < AR_ECS_MAX_COMPONENTS; id++)
+            {
+                if (shared_offsets[id] >= 0)
+                {
+                    const uint8* value = entity.DataOffsets[id] >= 0 ? &m_ComponentData[entity.DataOffsets[id]] : src->GetSharedComponentData(id);
+                    memcpy(shared_data.data() + shared_offsets[id], value, m_Registry->m_ComponentSizes[id]);
+                }
+            }
+
+            dst = m_Registry->RequestArchetype(desc, shared_data.data());
+        }
+
+        if (src != dst)
+        {
+            moves[{src, dst}].push_back(entity.Entity);
+        }
+    }
+
+    for (auto& move : moves)
+    {
+        m_Registry->MoveEntities(move.first.first, move.first.second, move.second);
+    }
+
+    // Write recorded component values at the final location
+    for (PendingEntity& entity : pending)
+    {
+        if (entity.Destroyed)
+        {
+            continue;
+        }
+
+        Archetype* archetype = m_Registry->GetArchetype(entity.Entity);
+        uint32 index = m_Registry->GetArchetypeIndex(entity.Entity);
+
+        for (uint32 column = 0; archetype && column < archetype->ComponentTypes.size(); column++)
+        {
+            int32 offset = entity.DataOffsets[archetype->ComponentTypes[column]];
+            if (offset >= 0)
+            {
+                memcpy(archetype->GetComponentData(column, index), &m_ComponentData[offset], archetype->ComponentSizes[column]);
+                archetype->MarkChanged(column, index);
+            }
+        }
+    }
+
+    Clear();
+}
+
+void EntityCommandBuffer::Clear()
+{
+    m_Commands.clear();
+    m_ComponentData.clear();
+}
@@ -0,0 +1,92 @@
+#pragma once
+
+#include <vector>
+
+#include "Artifice/Core/Core.h"
+#include "Artifice/Core/Log.h"
+
+#include "Entity.h"
+
+
+// Records structural changes so they can be made while iterating the registry,
+// then plays them back in one pass. Playback folds all commands per entity, then
+// moves entities grouped by (source, destination) archetype.
+// Recording is not thread safe.
+class EntityCommandBuffer
+{
+private:
+    enum class CommandType : uint8
+    {
+        Destroy,
+        AddComponent,
+        RemoveComponent
+    };
+
+    struct Command
+    {
+        CommandType Type;
+        EntityHandle Entity;
+        uint32 ComponentID;
+        // Offset of the component value in m_ComponentData
+        uint32 DataOffset;
+    };
+
+    EntityRegistry* m_Registry = nullptr;
+    std::vector<Command> m_Commands;
+    std::vector<uint8> m_ComponentData;
+
+public:
+    EntityCommandBuffer() = default;
+    EntityCommandBuffer(EntityRegistry* registry) : m_Registry(registry) {}
+
+    void Init(EntityRegistry* registry)
+    {
+        m_Registry = registry;
+    }
+
+    // Entities without components are not part of any archetype, so the handle is created immediately
+    EntityHandle CreateEntity()
+    {
+        return m_Registry->CreateEntity();
+    }
+
+    void DestroyEntity(EntityHandle entity)
+    {
+        m_Commands.push_back({CommandType::Destroy, entity, 0, 0});
+    }
+
+    // Adding a component the entity already has overwrites it on playback
+    template <class C, typename... Args>
+    void AddComponent(EntityHandle entity, Args&&... args)
+    {
+        C component(std::forward<Args>(args)...);
+        AddComponentInternal(entity, Component<C>::GetTypeID(), &component, sizeof(C));
+    }
+
+    template <class C>
+    void AddComponent(EntityHandle entity, C component)
+    {
+        AddComponentInternal(entity, Component<C>::GetTypeID(), &component, sizeof(C));
+    }
+
+    template <class C>
+    void RemoveComponent(EntityHandle entity)
+    {
+        m_Commands.push_back({CommandType::RemoveComponent, entity, Component<C>::GetTypeID(), 0});
+    }
+
+    bool Empty() const { return m_Commands.empty(); }
+
+    void Playback();
+    void Clear();
+
+private:
+    void AddComponentInternal(EntityHandle entity, uint32 id, const void* data, uint32 size)
+    {
+        uint32 offset = m_ComponentData.size();
+        m_ComponentData.resize(offset + size);
+        memcpy(&m_ComponentData[offset], data, size);
+
+        m_Commands.push_back({CommandType::AddComponent, entity, id, offset});
+    }
+};
@@ -0,0 +1,372 @@
+#include "EntitySnapshot.h"
+
+#include <fstream>
+
+#include "Artifice/Core/Log.h"
+#include "Artifice/Debug/Instrumentor.h"
+
+static uint64 AlignUp(uint64 value, uint64 alignment)
+{
+    return (value + alignment - 1) & ~(alignment - 1);
+}
+
+bool EntitySnapshot::Save(EntityRegistry* registry, const std::string& path)
+{
+    AR_PROFILE_FUNCTION();
+
+    std::vector<Archetype*> archetypes;
+    for (Archetype* archetype : registry->m_Archetypes)
+    {
+        if (archetype->EntityCount == 0)
+        {
+            continue;
+        }
+
+        for (uint32 id : archetype->Description.GetComponentTypes())
+        {
+            if (!registry->m_ComponentStableIDs[id])
+            {
+                AR_CORE_ERROR("Tried saving snapshot with component %u that was registered without a name", id);
+                return false;
+            }
+        }
+        archetypes.push_back(archetype);
+    }
+
+    const std::vector<uint8>& generations = registry->m_HandleAllocator.GetGenerations();
+    const std::vector<uint32>& free_indices = registry->m_HandleAllocator.GetFreeIndices();
+
+    // Layout: header, handle allocator state, archetype table, component tables, chunk data
+    SnapshotHeader header = {};
+    header.Magic = AR_SNAPSHOT_MAGIC;
+    header.Version = AR_SNAPSHOT_VERSION;
+    header.ArchetypeCount = archetypes.size();
+    header.GenerationCount = generations.size();
+    header.FreeIndexCount = free_indices.size();
+
+    uint64 offset = sizeof(SnapshotHeader);
+    header.HandleOffset = offset;
+    offset += free_indices.size() * sizeof(uint32) + generations.size();
+
+    offset = AlignUp(offset, 8);
+    header.ArchetypeOffset = offset;
+    offset += archetypes.size() * sizeof(SnapshotArchetype);
+
+    std::vector<SnapshotArchetype> entries(archetypes.size());
+    for (uint32 i = 0; i < archetypes.size(); i++)
+    {
+        SnapshotArchetype& entry = entries[i];
+        entry = {};
+        entry.ComponentCount = archetypes[i]->ComponentTypes.size();
+        entry.EntityCount = archetypes[i]->EntityCount;
+        entry.ChunkCount = archetypes[i]->Chunks.size();
+        entry.ChunkCapacity = archetypes[i]->ChunkCapacity;
+        entry.ChunkSize = archetypes[i]->ChunkSize;
+        entry.SharedComponentCount = archetypes[i]->SharedTypes.size();
+        entry.ComponentOffset = offset;
+        offset += (entry.ComponentCount + entry.SharedComponentCount) * sizeof(SnapshotComponent);
+        entry.SharedDataOffset = offset;
+        offset += archetypes[i]->SharedData.size();
+    }
+    for (SnapshotArchetype& entry : entries)
+    {
+        offset = AlignUp(offset, AR_SNAPSHOT_CHUNK_ALIGNMENT);
+        entry.DataOffset = offset;
+        offset += (uint64)entry.ChunkCount * entry.ChunkSize;
+    }
+
+    std::ofstream file(path, std::ios::binary);
+    if (!file.is_open())
+    {
+        AR_CORE_ERROR("Failed to open file %s", path.c_str());
+        return false;
+    }
+
+    uint64 written = 0;
+    auto write = [&](const void* data, uint64 size) {
+        file.write((const char*)data, size);
+        written += size;
+    };
+    auto pad_to = [&](uint64 target) {
+        static const char zeros[AR_SNAPSHOT_CHUNK_ALIGNMENT] = {};
+        AR_CORE_ASSERT(target - written <= sizeof(zeros), "Snapshot padding out of range");
+        write(zeros, target - written);
+    };
+
+    write(&header, sizeof(header));
+    write(free_indices.data(), free_indices.size() * sizeof(uint32));
+    write(generations.data(), generations.size());
+
+    pad_to(header.ArchetypeOffset);
+    write(entries.data(), entries.size() * sizeof(SnapshotArchetype));
+
+    for (Archetype* archetype : archetypes)
+    {
+        for (uint32 column = 0; column < archetype->ComponentTypes.size(); column++)
+        {
+            SnapshotComponent component;
+            component.StableID = registry->m_ComponentStableIDs[archetype->ComponentTypes[column]];
+            component.Size = archetype->ComponentSizes[column];
+            component.ColumnOffset = archetype->ColumnOffsets[column];
+            write(&component, sizeof(component));
+        }
+        for (uint32 id : archetype->SharedTypes)
+        {
+            SnapshotComponent component;
+            component.StableID = registry->m_ComponentStableIDs[id];
+            component.Size = registry->m_ComponentSizes[id];
+            component.ColumnOffset = archetype->SharedOffsets[id];
+            write(&component, sizeof(component));
+        }
+        write(archetype->SharedData.data(), archetype->SharedData.size());
+    }
+
+    for (uint32 i = 0; i < archetypes.size(); i++)
+    {
+        pad_to(entries[i].DataOffset);
+        for (ArchetypeChunk& chunk : archetypes[i]->Chunks)
+        {
+            write(chunk.Data, archetypes[i]->ChunkSize);
+        }
+    }
+
+    AR_CORE_INFO("Saved snapshot %s with %u archetypes (%llu bytes)", path.c_str(), header.ArchetypeCount, (unsigned long long)written);
+
+    return file.good();
+}
+
+bool EntitySnapshot::Load(EntityRegistry* registry, const std::string& path)
+{
+    AR_PROFILE_FUNCTION();
+
+    AR_CORE_ASSERT(registry->m_HandleAllocator.GetCapacity() == 0, "Tried loading snapshot into registry that already has entities");
+
+    MappedFile* file = new MappedFile();
+    if (!file->Open(path))
+    {
+        delete file;
+        return false;
+    }
+
+    uint8* data = file->GetData();
+    uint64 size = file->GetSize();
+
+    auto fail = [&](const char* reason) {
+        AR_CORE_ERROR("Failed to load snapshot %s: %s", path.c_str(), reason);
+        delete file;
+        return false;
+    };
+    auto in_bounds = [&](uint64 offset, uint64 length) {
+        return offset <= size && length <= size - offset;
+    };
+
+    if (!in_bounds(0, sizeof(SnapshotHeader)))
+    {
+        return fail("file too small");
+    }
+    SnapshotHeader header = *(SnapshotHeader*)data;
+    if (header.Magic != AR_SNAPSHOT_MAGIC || header.Version != AR_SNAPSHOT_VERSION)
+    {
+        return fail("unknown format or version");
+    }
+    if (!in_bounds(header.HandleOffset, header.FreeIndexCount * sizeof(uint32) + (uint64)header.GenerationCount) ||
+        !in_bounds(header.ArchetypeOffset, header.ArchetypeCount * sizeof(SnapshotArchetype)))
+    {
+        return fail("tables out of range");
+    }
+
+    // Validate and resolve everything before the registry is modified
+    struct ResolvedArchetype
+    {
+        const SnapshotArchetype* Entry;
+        const SnapshotComponent* Components;
+        ArchetypeDescription Description;
+        uint32 ComponentIDs[AR_ECS_MAX_COMPONENTS];
+        // Laid out for the loading registry
+        std::vector<uint8> SharedData;
+    };
+    std::vector<ResolvedArchetype> resolved(header.ArchetypeCount);
+
+    const SnapshotArchetype* entries = (const SnapshotArchetype*)(data + header.ArchetypeOffset);
+    for (uint32 i = 0; i < header.ArchetypeCount; i++)
+    {
+        ResolvedArchetype& archetype = resolved[i];
+        archetype.Entry = &entries[i];
+
+        const SnapshotArchetype& entry = entries[i];
+        uint32 total_count = entry.ComponentCount + entry.SharedComponentCount;
+        if (total_count > AR_ECS_MAX_COMPONENTS || !in_bounds(entry.ComponentOffset, total_count * sizeof(SnapshotComponent)) ||
+            !in_bounds(entry.DataOffset, (uint64)entry.ChunkCount * entry.ChunkSize))
+        {
+            return fail("archetype out of range");
+        }
+        // Chunks are full except the last one, the entity count of every chunk is derived from this
+        if (entry.ChunkCapacity == 0 || entry.ChunkCount != ((uint64)entry.EntityCount + entry.ChunkCapacity - 1) / entry.ChunkCapacity)
+        {
+            return fail("chunk count doesn't match entity count");
+        }
+        if ((uint64)entry.ChunkCapacity * sizeof(EntityHandle) > entry.ChunkSize)
+        {
+            return fail("entity handles out of range");
+        }
+
+        archetype.Components = (const SnapshotComponent*)(data + entry.ComponentOffset);
+        for (uint32 c = 0; c < entry.ComponentCount; c++)
+        {
+            const SnapshotComponent& component = archetype.Components[c];
+            int32 id = registry->FindComponent(component.StableID);
+            if (id < 0 || registry->m_ComponentSizes[id] != component.Size || registry->m_SharedComponents.test(id))
+            {
+                return fail("component not registered or changed");
+            }
+            if ((uint64)component.ColumnOffset + (uint64)entry.ChunkCapacity * component.Size > entry.ChunkSize)
+            {
+                return fail("column out of range");
+            }
+
+            archetype.ComponentIDs[c] = id;
+            archetype.Description.Add(id);
+        }
+
+        int32 shared_offsets[AR_ECS_MAX_COMPONENTS];
+        ComponentSignature shared_components;
+        for (uint32 c = entry.ComponentCount; c < total_count; c++)
+        {
+            const SnapshotComponent& component = archetype.Components[c];
+            int32 id = registry->FindComponent(component.StableID);
+            if (id < 0 || registry->m_ComponentSizes[id] != component.Size || !registry->m_SharedComponents.test(id))
+            {
+                return fail("shared component not registered or changed");
+            }
+            if (!in_bounds(entry.SharedDataOffset, (uint64)component.ColumnOffset + component.Size))
+            {
+                return fail("shared value out of range");
+            }
+
+            archetype.ComponentIDs[c] = id;
+            archetype.Description.Add(id);
+            shared_components.set(id);
+        }
+
+        archetype.SharedData.resize(Archetype::GetSharedLayout(shared_components, registry->m_ComponentSizes, shared_offsets));
+        for (uint32 c = entry.ComponentCount; c < total_count; c++)
+        {
+            const SnapshotComponent& component = archetype.Components[c];
+            memcpy(archetype.SharedData.data() + shared_offsets[archetype.ComponentIDs[c]], data + entry.SharedDataOffset + component.ColumnOffset, component.Size);
+        }
+    }
+
+    // Every free index and stored entity refers to its own slot, entities with the current generation of the slot
+    const uint32* free_indices = (const uint32*)(data + header.HandleOffset);
+    const uint8* generations = data + header.HandleOffset + header.FreeIndexCount * sizeof(uint32);
+    std::vector<bool> used_slots(header.GenerationCount, false);
+    for (uint32 i = 0; i < header.FreeIndexCount; i++)
+    {
+        uint32 index = free_indices[i];
+        if (index >= header.GenerationCount || used_slots[index])
+        {
+            return fail("invalid free index");
+        }
+        used_slots[index] = true;
+    }
+    for (ResolvedArchetype& source : resolved)
+    {
+        const SnapshotArchetype& entry = *source.Entry;
+        for (uint32 i = 0; i < entry.ChunkCount; i++)
+        {
+            const EntityHandle* entities = (const EntityHandle*)(data + entry.DataOffset + (uint64)i * entry.ChunkSize);
+            uint32 count = std::min(entry.ChunkCapacity, entry.EntityCount - i * entry.ChunkCapacity);
+            for (uint32 e = 0; e < count; e++)
+            {
+                uint32 index = entities[e].GetIndex();
+                if (index >= header.GenerationCount || generations[index] != entities[e].GetGeneration() || used_slots[index])
+                {
+                    return fail("invalid or duplicate entity");
+                }
+                used_slots[index] = true;
+            }
+        }
+    }
+
+    registry->m_HandleAllocator.Restore(generations, header.GenerationCount, free_indices, header.FreeIndexCount);
+    registry->m_Entities.resize(header.GenerationCount);
+
+    bool mapped = false;
+    for (ResolvedArchetype& source : resolved)
+    {
+        const SnapshotArchetype& entry = *source.Entry;
+        Archetype* archetype = registry->RequestArchetype(source.Description, source.SharedData.data());
+        AR_CORE_ASSERT(archetype->EntityCount == 0, "Tried loading snapshot into non empty archetype");
+
+        bool same_layout = archetype->ChunkSize == entry.ChunkSize && archetype->ChunkCapacity == entry.ChunkCapacity;
+        for (uint32 c = 0; c < entry.ComponentCount && same_layout; c++)
+        {
+            same_layout = archetype->ColumnOffsets[archetype->GetColumn(source.ComponentIDs[c])] == source.Components[c].ColumnOffset;
+        }
+
+        if (same_layout)
+        {
+            // Chunks point straight into the mapping
+            uint32 version = registry->NextChangeVersion();
+            for (uint32 i = 0; i < entry.ChunkCount; i++)
+            {
+                ArchetypeChunk chunk;
+                chunk.Data = data + entry.DataOffset + (uint64)i * entry.ChunkSize;
+                chunk.Count = std::min(entry.ChunkCapacity, entry.EntityCount - i * entry.ChunkCapacity);
+                chunk.ColumnVersions.assign(archetype->ComponentSizes.size(), version);
+                chunk.Mapped = true;
+                archetype->Chunks.push_back(chunk);
+            }
+            archetype->EntityCount = entry.EntityCount;
+            archetype->StructureVersion = version;
+            mapped = true;
+        }
+        else
+        {
+            // Component ids or chunk layout differ from the saving registry, copy column by column
+            for (uint32 i = 0; i < entry.ChunkCount; i++)
+            {
+                uint8* chunk_data = data + entry.DataOffset + (uint64)i * entry.ChunkSize;
+                uint32 count = std::min(entry.ChunkCapacity, entry.EntityCount - i * entry.ChunkCapacity);
+                uint32 first_index = archetype->PushEntities((EntityHandle*)chunk_data, count);
+
+                for (uint32 c = 0; c < entry.ComponentCount; c++)
+                {
+                    uint32 column = archetype->GetColumn(source.ComponentIDs[c]);
+                    uint32 component_size = source.Components[c].Size;
+                    uint8* src = chunk_data + source.Components[c].ColumnOffset;
+
+                    // Copy in runs that do not cross a destination chunk boundary
+                    uint32 copied = 0;
+                    while (copied < count)
+                    {
+                        uint32 dst_index = first_index + copied;
+                        uint32 run = std::min(count - copied, archetype->ChunkCapacity - dst_index % archetype->ChunkCapacity);
+                        memcpy(archetype->GetComponentData(column, dst_index), src + copied * component_size, run * component_size);
+                        copied += run;
+                    }
+                }
+            }
+        }
+
+        for (uint32 index = 0; index < archetype->EntityCount; index++)
+        {
+            EntityHandle entity = archetype->GetEntityHandle(index);
+            AR_CORE_ASSERT(registry->IsAlive(entity), "Snapshot contains entity that is not alive");
+            registry->m_Entities[entity.GetIndex()] = {archetype, index};
+        }
+    }
+
+    if (mapped)
+    {
+        registry->m_MappedFiles.push_back(file);
+    }
+    else
+    {
+        delete file;
+    }
+
+    AR_CORE_INFO("Loaded snapshot %s with %u archetypes", path.c_str(), header.ArchetypeCount);
+
+    return true;
+}
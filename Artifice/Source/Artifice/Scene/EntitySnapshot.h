@@ -0,0 +1,62 @@
+#pragma once
+
+#include <string>
+
+#include "Artifice/Core/Core.h"
+
+#include "Entity.h"
+
+// Binary image of an EntityRegistry. Archetypes are stored with their chunks verbatim, so loading maps the file and
+// points the archetype chunks into it. Components are matched by the stable id of their registered name, and only
+// chunks whose layout differs in the loading registry are copied column by column.
+// Components are stored as raw bytes, pointers they contain are not meaningful after loading.
+#define AR_SNAPSHOT_MAGIC 0x53455241 // "ARES"
+#define AR_SNAPSHOT_VERSION 2
+// Chunk data alignment in the file
+#define AR_SNAPSHOT_CHUNK_ALIGNMENT 64
+
+struct SnapshotHeader
+{
+    uint32 Magic;
+    uint32 Version;
+    uint32 ArchetypeCount;
+    uint32 GenerationCount;
+    uint32 FreeIndexCount;
+    uint32 Padding;
+    // uint32 free indices followed by uint8 generations
+    uint64 HandleOffset;
+    uint64 ArchetypeOffset;
+};
+
+struct SnapshotArchetype
+{
+    uint32 ComponentCount;
+    uint32 EntityCount;
+    uint32 ChunkCount;
+    uint32 ChunkCapacity;
+    uint32 ChunkSize;
+    uint32 SharedComponentCount;
+    // SnapshotComponent per column, followed by one per shared component
+    uint64 ComponentOffset;
+    // Shared component values, laid out as Archetype::SharedData
+    uint64 SharedDataOffset;
+    // ChunkCount chunks of ChunkSize bytes
+    uint64 DataOffset;
+};
+
+struct SnapshotComponent
+{
+    uint64 StableID;
+    uint32 Size;
+    // Offset in the chunk, or in the shared data for shared components
+    uint32 ColumnOffset;
+};
+
+class EntitySnapshot
+{
+public:
+    // Every component in the registry must be registered with a name
+    static bool Save(EntityRegistry* registry, const std::string& path);
+    // Registry must not contain entities, components need to be registered with the names used when saving
+    static bool Load(EntityRegistry* registry, const std::string& path);
+};
@@ -11,12 +11,20 @@
 
 #include "Entity.h"
 #include "Component.h"
+#include "TransformHierarchy.h"
+#include "SystemScheduler.h"
+#include "SpatialIndex.h"
 
 
 class Scene
 {
 private:
     EntityRegistry* m_Registry;
+    Query<const MeshComponent> m_MeshQuery;
+    Query<const MeshComponent, const TransformComponent> m_TransformedMeshQuery;
+    TransformHierarchy m_TransformHierarchy;
+    SpatialIndex m_SpatialIndex;
+    SystemScheduler m_Scheduler;
 
     RenderHandle m_BRDFTexture;
     RenderHandle m_BRDFSampler;
@@ -28,11 +36,30 @@ public:
     void Init()
     {
         m_Registry = new EntityRegistry();
-        m_Registry->RegisterComponent<MeshComponent>();
-        m_Registry->RegisterComponent<TransformComponent>();
+        m_Registry->RegisterComponent<MeshComponent>("MeshComponent");
+        m_Registry->RegisterComponent<TransformComponent>("TransformComponent");
+        m_Registry->RegisterComponent<LocalTransformComponent>("LocalTransformComponent");
+        m_Registry->RegisterComponent<ParentComponent>("ParentComponent");
+        m_Registry->RegisterComponent<BoxCollider>("BoxCollider");
+
+        m_MeshQuery.Init(m_Registry);
+        m_TransformedMeshQuery.Init(m_Registry);
+        m_TransformHierarchy.Init(m_Registry);
+        m_SpatialIndex.Init(m_Registry);
+
+        m_Scheduler.Init(m_Registry, Application::Get()->GetJobSystem());
+        m_Scheduler.AddSystem("TransformHierarchy",
+            SystemAccess().Read<LocalTransformComponent, ParentComponent>().Write<TransformComponent>(),
+            [this](EntityRegistry* registry, Timestep ts) { m_TransformHierarchy.Update(); });
+        m_Scheduler.AddSystem("SpatialIndex",
+            SystemAccess().Read<BoxCollider, TransformComponent>(),
+            [this](EntityRegistry* registry, Timestep ts) { m_SpatialIndex.Update(); });
     }
     void CleanUp()
     {
+        m_Scheduler.CleanUp();
+        m_SpatialIndex.CleanUp();
+        m_TransformHierarchy.CleanUp();
         delete m_Registry;
         m_Registry = nullptr;
         if (m_IBLSet)
@@ -42,33 +69,36 @@ public:
     }
     void OnUpdate(Timestep ts)
     {
-        
+        m_Scheduler.Run(ts);
     }
 
     void Render(CommandBuffer* cmd, PerspectiveCamera camera, RenderPassLayout rpl)
     {
-        std::vector<EntityHandle> entities =  m_Registry->GetEntitiesWith<MeshComponent, TransformComponent>();
-
         SceneRenderer::BeginScene(GetEnvironment(), camera, rpl, cmd);
         
-        for (Archetype* archetype : m_Registry->GetArchetypesWith<MeshComponent>())
+        // Meshes are shared components, so every chunk holds the transforms of one mesh contiguously
+        static_assert(sizeof(TransformComponent) == sizeof(mat4), "TransformComponent is submitted as an array of mat4");
+        for (Archetype* archetype : m_TransformedMeshQuery.GetArchetypes())
+        {
+            Mesh* mesh = archetype->GetSharedComponent<MeshComponent>()->Mesh;
+            for (ArchetypeChunk& chunk : archetype->Chunks)
+            {
+                const TransformComponent* transforms = archetype->GetComponents<const TransformComponent>(chunk);
+                SceneRenderer::SubmitMeshInstances(mesh, &transforms->Transform, chunk.Count);
+            }
+        }
+
+        for (Archetype* archetype : m_MeshQuery.GetArchetypes())
         {
-            bool has_transform = archetype->Contains<TransformComponent>();
-            MeshComponent* meshes = archetype->GetComponents<MeshComponent>();
-            if (has_transform)
+            if (archetype->Contains<TransformComponent>())
             {
-                TransformComponent* transforms = archetype->GetComponents<TransformComponent>();
-                for (uint32 i = 0; i < archetype->EntityHandles.size(); i++)
-                {
-                    SceneRenderer::SubmitMesh(meshes[i].Mesh, transforms[i].Transform);
-                }
+                continue;
             }
-            else
+
+            Mesh* mesh = archetype->GetSharedComponent<MeshComponent>()->Mesh;
+            for (uint32 i = 0; i < archetype->EntityCount; i++)
             {
-                for (uint32 i = 0; i < archetype->EntityHandles.size(); i++)
-                {
-                    SceneRenderer::SubmitMesh(meshes[i].Mesh, mat4::identity());
-                }
+                SceneRenderer::SubmitMesh(mesh, mat4::identity());
             }
         }
 
@@ -93,4 +123,8 @@ public:
     }
 
     EntityRegistry* GetRegistry() { return m_Registry; }
+    // Systems added here run every OnUpdate
+    SystemScheduler* GetScheduler() { return &m_Scheduler; }
+    // Bounds of entities with a BoxCollider, updated every OnUpdate
+    const SpatialIndex& GetSpatialIndex() const { return m_SpatialIndex; }
 };
\ No newline at end of file
@@ -0,0 +1,120 @@
+#include "SpatialIndex.h"
+
+#include "Artifice/Debug/Instrumentor.h"
+
+void SpatialIndex::Init(EntityRegistry* registry, float margin)
+{
+    m_Registry = registry;
+    m_Query.Init(registry);
+    m_Tree.Init(margin);
+}
+
+void SpatialIndex::CleanUp()
+{
+    m_Tree.CleanUp();
+    m_Entries.clear();
+    m_Archetypes.clear();
+    m_Registry = nullptr;
+}
+
+void SpatialIndex::Update()
+{
+    AR_PROFILE_FUNCTION();
+
+    // Entities were added or removed, visit every chunk so removed entities can be found
+    bool stale = IsStale();
+    uint32 since_version = stale ? 0 : m_LastUpdateVersion;
+    uint32 version = m_Registry->GetChangeVersion();
+    m_UpdateIndex++;
+
+    m_Query.EachChanged(since_version, [this](EntityHandle entity, const BoxCollider& collider, const TransformComponent& transform) {
+        uint32 index = entity.GetIndex();
+        if (index >= m_Entries.size())
+        {
+            m_Entries.resize(index + 1);
+        }
+
+        Entry& entry = m_Entries[index];
+        entry.Bounds = collider.BoundingBox.Transformed(transform.Transform);
+        entry.UpdateIndex = m_UpdateIndex;
+
+        // Slot reused by a new entity before the old one's proxy was removed
+        if (entry.Proxy != AR_BVH_NULL_NODE && entry.Entity != entity)
+        {
+            m_Tree.DestroyProxy(entry.Proxy);
+            entry.Proxy = AR_BVH_NULL_NODE;
+        }
+        entry.Entity = entity;
+
+        if (entry.Proxy == AR_BVH_NULL_NODE)
+        {
+            entry.Proxy = m_Tree.CreateProxy(entry.Bounds, index);
+        }
+        else
+        {
+            m_Tree.MoveProxy(entry.Proxy, entry.Bounds);
+        }
+    });
+
+    if (stale)
+    {
+        for (Entry& entry : m_Entries)
+        {
+            if (entry.Proxy != AR_BVH_NULL_NODE && entry.UpdateIndex != m_UpdateIndex)
+            {
+                m_Tree.DestroyProxy(entry.Proxy);
+                entry.Proxy = AR_BVH_NULL_NODE;
+            }
+        }
+
+        m_Archetypes.clear();
+        for (Archetype* archetype : m_Query.GetArchetypes())
+        {
+            m_Archetypes.push_back({archetype, archetype->StructureVersion});
+        }
+    }
+
+    m_LastUpdateVersion = version;
+}
+
+bool SpatialIndex::RayCast(const vec3& origin, const vec3& direction, float max_distance, RaycastHit& hit) const
+{
+    vec3 inverse_direction(1.0f / direction.x, 1.0f / direction.y, 1.0f / direction.z);
+
+    bool found = false;
+    m_Tree.QueryRay(origin, direction, max_distance, [&](uint32 index, float current_max) {
+        const Entry& entry = m_Entries[index];
+
+        float distance;
+        if (!entry.Bounds.IntersectRay(origin, inverse_direction, current_max, distance))
+        {
+            return current_max;
+        }
+
+        hit.Entity = entry.Entity;
+        hit.Distance = distance;
+        found = true;
+        return distance;
+    });
+
+    return found;
+}
+
+bool SpatialIndex::IsStale()
+{
+    const std::vector<Archetype*>& archetypes = m_Query.GetArchetypes();
+    if (archetypes.size() != m_Archetypes.size())
+    {
+        return true;
+    }
+
+    for (const ArchetypeState& state : m_Archetypes)
+    {
+        if (state.Owner->StructureVersion != state.StructureVersion)
+        {
+            return true;
+        }
+    }
+
+    return false;
+}
@@ -0,0 +1,93 @@
+#pragma once
+
+#include <vector>
+
+#include "Artifice/Core/Core.h"
+#include "Artifice/math/math.h"
+#include "Artifice/math/Frustum.h"
+
+#include "Entity.h"
+#include "Component.h"
+#include "DynamicBVH.h"
+
+struct RaycastHit
+{
+    EntityHandle Entity;
+    float Distance;
+};
+
+// World space bounds of every entity with a BoxCollider and TransformComponent, indexed by a DynamicBVH.
+// Update only visits chunks where either component changed since the last update, and entities only move in the
+// tree when their bounds leave the fat box. Queries test the exact world bounds of the candidates from the tree.
+class SpatialIndex
+{
+private:
+    struct Entry
+    {
+        EntityHandle Entity;
+        int32 Proxy = AR_BVH_NULL_NODE;
+        AABB Bounds;
+        // Update in which the entity was last seen, for finding removed entities
+        uint32 UpdateIndex = 0;
+    };
+    struct ArchetypeState
+    {
+        Archetype* Owner;
+        uint32 StructureVersion;
+    };
+
+    EntityRegistry* m_Registry = nullptr;
+    Query<const BoxCollider, const TransformComponent> m_Query;
+    DynamicBVH m_Tree;
+
+    // Indexed by entity index, also the user data of the proxies
+    std::vector<Entry> m_Entries;
+
+    // Structure of every matching archetype at the last update, entities were only added or removed when changed
+    std::vector<ArchetypeState> m_Archetypes;
+    uint32 m_LastUpdateVersion = 0;
+    uint32 m_UpdateIndex = 0;
+
+public:
+    // margin enlarges the boxes in the tree, so entities moving less than it are not reinserted
+    void Init(EntityRegistry* registry, float margin = 0.1f);
+    void CleanUp();
+
+    void Update();
+
+    // Calls func(EntityHandle) for every entity whose bounds overlap box
+    template <class F>
+    void QueryOverlap(const AABB& box, F&& func) const
+    {
+        m_Tree.QueryOverlap(box, [&](uint32 index) {
+            const Entry& entry = m_Entries[index];
+            if (entry.Bounds.Overlaps(box))
+            {
+                func(entry.Entity);
+            }
+        });
+    }
+
+    // Calls func(EntityHandle) for every entity whose bounds are at least partially inside the frustum
+    template <class F>
+    void QueryFrustum(const Frustum& frustum, F&& func) const
+    {
+        m_Tree.QueryFrustum(frustum, [&](uint32 index) {
+            const Entry& entry = m_Entries[index];
+            if (frustum.IsBoxVisible(entry.Bounds))
+            {
+                func(entry.Entity);
+            }
+        });
+    }
+
+    // Closest entity whose bounds the ray hits within max_distance
+    bool RayCast(const vec3& origin, const vec3& direction, float max_distance, RaycastHit& hit) const;
+
+    const AABB& GetBounds(EntityHandle entity) const { return m_Entries[entity.GetIndex()].Bounds; }
+    uint32 GetEntityCount() const { return m_Tree.GetProxyCount(); }
+    const DynamicBVH& GetTree() const { return m_Tree; }
+
+private:
+    bool IsStale();
+};
@@ -0,0 +1,175 @@
+#include "SystemScheduler.h"
+
+#include <algorithm>
+#include <fstream>
+
+#include "Artifice/Core/Log.h"
+#include "Artifice/Debug/Instrumentor.h"
+
+void SystemScheduler::Init(EntityRegistry* registry, JobSystem* jobs)
+{
+    m_Registry = registry;
+    m_Jobs = jobs;
+}
+
+void SystemScheduler::CleanUp()
+{
+    for (System* system : m_Systems)
+    {
+        delete system;
+    }
+    m_Systems.clear();
+    m_Timeline.clear();
+    m_Registry = nullptr;
+    m_Jobs = nullptr;
+}
+
+void SystemScheduler::AddSystem(const std::string& name, const SystemAccess& access, SystemFunction function)
+{
+    System* system = new System();
+    system->Name = name;
+    system->Access = access;
+    system->Function = std::move(function);
+    m_Systems.push_back(system);
+    m_GraphDirty = true;
+}
+
+void SystemScheduler::Run(Timestep ts)
+{
+    AR_PROFILE_FUNCTION();
+
+    if (m_Systems.empty())
+    {
+        return;
+    }
+
+    if (m_GraphDirty)
+    {
+        BuildGraph();
+    }
+
+    // Systems only read the query caches while running concurrently
+    m_Registry->RefreshQueryCaches();
+
+    m_Timeline.resize(m_Systems.size());
+    m_FrameStart = std::chrono::high_resolution_clock::now();
+
+    // Registration order is a valid topological order
+    if (!m_Jobs)
+    {
+        for (uint32 i = 0; i < m_Systems.size(); i++)
+        {
+            RunSystem(i, ts, nullptr);
+        }
+        return;
+    }
+
+    for (System* system : m_Systems)
+    {
+        system->RemainingDependencies.store(system->DependencyCount, std::memory_order_relaxed);
+    }
+
+    // Systems sharing a new query cache would race on creating it
+    m_Registry->LockQueryCaches(true);
+
+    JobCounter counter;
+    for (uint32 i = 0; i < m_Systems.size(); i++)
+    {
+        if (m_Systems[i]->DependencyCount == 0)
+        {
+            m_Jobs->Execute([this, i, ts, &counter]() { RunSystem(i, ts, &counter); }, &counter);
+        }
+    }
+    m_Jobs->Wait(&counter);
+
+    m_Registry->LockQueryCaches(false);
+}
+
+bool SystemScheduler::DumpTimeline(const std::string& path) const
+{
+    std::ofstream stream(path);
+    if (!stream)
+    {
+        AR_CORE_ERROR("Failed to open %s for writing", path.c_str());
+        return false;
+    }
+
+    stream << "{\"otherData\": {},\"traceEvents\":[";
+    for (uint32 i = 0; i < m_Timeline.size(); i++)
+    {
+        const SystemTiming& timing = m_Timeline[i];
+        std::string name = timing.Name;
+        std::replace(name.begin(), name.end(), '"', '\'');
+
+        if (i > 0)
+        {
+            stream << ",";
+        }
+        stream << "{";
+        stream << "\"cat\":\"system\",";
+        stream << "\"dur\":" << (timing.End - timing.Start) << ',';
+        stream << "\"name\":\"" << name << "\",";
+        stream << "\"ph\":\"X\",";
+        stream << "\"pid\":0,";
+        stream << "\"tid\":" << timing.ThreadIndex << ",";
+        stream << "\"ts\":" << timing.Start;
+        stream << "}";
+    }
+    stream << "]}";
+
+    return true;
+}
+
+void SystemScheduler::BuildGraph()
+{
+    // Only the closest conflicting predecessor for every accessed component would be needed,
+    // but system counts are small and redundant edges only cost a counter decrement
+    for (System* system : m_Systems)
+    {
+        system->Dependents.clear();
+        system->DependencyCount = 0;
+    }
+
+    for (uint32 j = 1; j < m_Systems.size(); j++)
+    {
+        for (uint32 i = 0; i < j; i++)
+        {
+            if (m_Systems[i]->Access.ConflictsWith(m_Systems[j]->Access))
+            {
+                m_Systems[i]->Dependents.push_back(j);
+                m_Systems[j]->DependencyCount++;
+            }
+        }
+    }
+
+    m_GraphDirty = false;
+}
+
+void SystemScheduler::RunSystem(uint32 index, Timestep ts, JobCounter* counter)
+{
+    System* system = m_Systems[index];
+
+    auto start = std::chrono::high_resolution_clock::now();
+    system->Function(m_Registry, ts);
+    auto end = std::chrono::high_resolution_clock::now();
+
+    SystemTiming& timing = m_Timeline[index];
+    timing.Name = system->Name;
+    timing.Start = std::chrono::duration_cast<std::chrono::microseconds>(start - m_FrameStart).count();
+    timing.End = std::chrono::duration_cast<std::chrono::microseconds>(end - m_FrameStart).count();
+    timing.ThreadIndex = JobSystem::GetThreadIndex();
+
+    if (!counter)
+    {
+        return;
+    }
+
+    // The counter still includes this job, so it can't reach zero before the dependents are queued
+    for (uint32 dependent : system->Dependents)
+    {
+        if (m_Systems[dependent]->RemainingDependencies.fetch_sub(1, std::memory_order_acq_rel) == 1)
+        {
+            m_Jobs->Execute([this, dependent, ts, counter]() { RunSystem(dependent, ts, counter); }, counter);
+        }
+    }
+}
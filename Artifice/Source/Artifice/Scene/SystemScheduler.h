@@ -0,0 +1,98 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <string>
+#include <vector>
+
+#include "Artifice/Core/Core.h"
+#include "Artifice/Core/JobSystem.h"
+#include "Artifice/Core/Timestep.h"
+
+#include "Entity.h"
+
+// Components a system reads and writes, systems conflict when one writes a component the other accesses
+struct SystemAccess
+{
+    ComponentSignature Reads;
+    ComponentSignature Writes;
+
+    template <class... Cs>
+    SystemAccess& Read()
+    {
+        (Reads.set(Component<Cs>::GetTypeID()), ...);
+        return *this;
+    }
+    template <class... Cs>
+    SystemAccess& Write()
+    {
+        (Writes.set(Component<Cs>::GetTypeID()), ...);
+        return *this;
+    }
+
+    bool ConflictsWith(const SystemAccess& other) const
+    {
+        return (Writes & (other.Reads | other.Writes)).any() || (other.Writes & Reads).any();
+    }
+};
+
+struct SystemTiming
+{
+    std::string Name;
+    // Microseconds since the start of the frame
+    long long Start, End;
+    uint32 ThreadIndex;
+};
+
+// Runs the registered systems of a registry once per frame. Systems are ordered by registration where their access
+// conflicts and run concurrently on the job system otherwise.
+// Systems must not change the registry structure (use an EntityCommandBuffer), must iterate through Query objects
+// initialized before Run, and must not dispatch jobs that outlive the system.
+class SystemScheduler
+{
+public:
+    using SystemFunction = std::function<void(EntityRegistry* registry, Timestep ts)>;
+
+private:
+    struct System
+    {
+        std::string Name;
+        SystemAccess Access;
+        SystemFunction Function;
+
+        // Systems that depend on this one, registered later
+        std::vector<uint32> Dependents;
+        uint32 DependencyCount = 0;
+        std::atomic<uint32> RemainingDependencies = {0};
+    };
+
+    EntityRegistry* m_Registry = nullptr;
+    JobSystem* m_Jobs = nullptr;
+
+    // Pointers since System holds an atomic
+    std::vector<System*> m_Systems;
+    bool m_GraphDirty = false;
+
+    std::vector<SystemTiming> m_Timeline;
+    std::chrono::time_point<std::chrono::high_resolution_clock> m_FrameStart;
+
+public:
+    // jobs may be nullptr to run every system on the calling thread
+    void Init(EntityRegistry* registry, JobSystem* jobs);
+    void CleanUp();
+
+    void AddSystem(const std::string& name, const SystemAccess& access, SystemFunction function);
+
+    void Run(Timestep ts);
+
+    uint32 GetSystemCount() const { return m_Systems.size(); }
+    // Per system timing of the last Run, in registration order
+    const std::vector<SystemTiming>& GetTimeline() const { return m_Timeline; }
+    // Writes the last timeline in the chrome://tracing format used by the Instrumentor
+    bool DumpTimeline(const std::string& path) const;
+
+private:
+    void BuildGraph();
+    void RunSystem(uint32 index, Timestep ts, JobCounter* counter);
+};
@@ -0,0 +1,237 @@
+#include "TransformHierarchy.h"
+
+#include <unordered_map>
+
+#include "Artifice/Core/Log.h"
+#include "Artifice/Debug/Instrumentor.h"
+
+void TransformHierarchy::Init(EntityRegistry* registry)
+{
+    m_Registry = registry;
+    m_WorldQuery.Init(registry);
+}
+
+void TransformHierarchy::CleanUp()
+{
+    m_Nodes.clear();
+    m_LevelOffsets.clear();
+    m_Archetypes.clear();
+    m_Registry = nullptr;
+}
+
+void TransformHierarchy::Update()
+{
+    AR_PROFILE_FUNCTION();
+
+    uint32 since_version = m_LastUpdateVersion;
+    if (IsStale())
+    {
+        Rebuild();
+        since_version = 0;
+    }
+
+    uint32 version = m_Registry->NextChangeVersion();
+
+    // Parents are on a lower level, so their world transforms are final when a level is processed
+    for (uint32 level = 0; level < GetDepthCount(); level++)
+    {
+        for (uint32 i = m_LevelOffsets[level]; i < m_LevelOffsets[level + 1]; i++)
+        {
+            Node& node = m_Nodes[i];
+
+            bool dirty = *node.LocalVersion > since_version || (node.ParentWorld && *node.ParentWorldVersion > since_version);
+            if (!dirty)
+            {
+                continue;
+            }
+
+            if (node.ParentWorld)
+            {
+                mat4::multiply(*node.ParentWorld, *node.Local, *node.World);
+            }
+            else
+            {
+                *node.World = *node.Local;
+            }
+            *node.WorldVersion = version;
+        }
+    }
+
+    m_LastUpdateVersion = version;
+}
+
+bool TransformHierarchy::IsStale()
+{
+    const std::vector<Archetype*>& archetypes = m_WorldQuery.GetArchetypes();
+    if (archetypes.size() != m_Archetypes.size())
+    {
+        return true;
+    }
+
+    uint32 parent_id = Component<ParentComponent>::GetTypeID();
+    for (const ArchetypeState& state : m_Archetypes)
+    {
+        if (state.Owner->StructureVersion != state.StructureVersion)
+        {
+            return true;
+        }
+
+        // Reparented entities
+        if (state.Owner->Contains(parent_id))
+        {
+            uint32 parent_column = state.Owner->GetColumn(parent_id);
+            for (const ArchetypeChunk& chunk : state.Owner->Chunks)
+            {
+                if (chunk.ColumnVersions[parent_column] > m_LastUpdateVersion)
+                {
+                    return true;
+                }
+            }
+        }
+    }
+
+    return false;
+}
+
+void TransformHierarchy::Rebuild()
+{
+    AR_PROFILE_FUNCTION();
+
+    struct PendingNode
+    {
+        Node Data;
+        EntityHandle Parent;
+        int32 ParentNode;
+        // -1 unresolved, -2 while resolving
+        int32 Depth;
+    };
+
+    uint32 local_id = Component<LocalTransformComponent>::GetTypeID();
+    uint32 world_id = Component<TransformComponent>::GetTypeID();
+    uint32 parent_id = Component<ParentComponent>::GetTypeID();
+
+    std::vector<PendingNode> pending;
+    std::unordered_map<EntityHandle, uint32> node_lookup;
+
+    m_Archetypes.clear();
+    for (Archetype* archetype : m_WorldQuery.GetArchetypes())
+    {
+        m_Archetypes.push_back({archetype, archetype->StructureVersion});
+
+        if (!archetype->Contains(local_id))
+        {
+            continue;
+        }
+
+        uint32 local_column = archetype->GetColumn(local_id);
+        uint32 world_column = archetype->GetColumn(world_id);
+        int32 parent_column = archetype->ColumnIndices[parent_id];
+
+        for (ArchetypeChunk& chunk : archetype->Chunks)
+        {
+            EntityHandle* entities = chunk.GetEntityHandles();
+            LocalTransformComponent* locals = (LocalTransformComponent*)archetype->GetComponentData(local_column, chunk);
+            TransformComponent* worlds = (TransformComponent*)archetype->GetComponentData(world_column, chunk);
+            ParentComponent* parents = parent_column >= 0 ? (ParentComponent*)archetype->GetComponentData(parent_column, chunk) : nullptr;
+
+            for (uint32 i = 0; i < chunk.Count; i++)
+            {
+                PendingNode node;
+                node.Data.Local = &locals[i].Transform;
+                node.Data.World = &worlds[i].Transform;
+                node.Data.LocalVersion = &chunk.ColumnVersions[local_column];
+                node.Data.WorldVersion = &chunk.ColumnVersions[world_column];
+                node.Parent = parents ? parents[i].Parent : EntityHandle();
+                node.ParentNode = -1;
+                node.Depth = -1;
+
+                node_lookup[entities[i]] = (uint32)pending.size();
+                pending.push_back(node);
+            }
+        }
+    }
+
+    // Resolve parents, either another node or an entity with only a world transform
+    for (PendingNode& node : pending)
+    {
+        if (node.Parent.IsNull() || !m_Registry->IsAlive(node.Parent))
+        {
+            continue;
+        }
+
+        auto it = node_lookup.find(node.Parent);
+        if (it != node_lookup.end())
+        {
+            node.ParentNode = it->second;
+            node.Data.ParentWorld = pending[it->second].Data.World;
+            node.Data.ParentWorldVersion = pending[it->second].Data.WorldVersion;
+            continue;
+        }
+
+        Archetype* parent_archetype = m_Registry->GetArchetype(node.Parent);
+        if (parent_archetype && parent_archetype->Contains(world_id))
+        {
+            uint32 column = parent_archetype->GetColumn(world_id);
+            uint32 index = m_Registry->GetArchetypeIndex(node.Parent);
+            node.Data.ParentWorld = &((TransformComponent*)parent_archetype->GetComponentData(column, index))->Transform;
+            node.Data.ParentWorldVersion = &parent_archetype->GetChunk(index).ColumnVersions[column];
+        }
+    }
+
+    // Depth of every node, walking up until a node with a known depth
+    uint32 depth_count = 0;
+    std::vector<uint32> chain;
+    for (uint32 i = 0; i < pending.size(); i++)
+    {
+        chain.clear();
+        int32 current = i;
+        while (current >= 0 && pending[current].Depth == -1)
+        {
+            pending[current].Depth = -2;
+            chain.push_back(current);
+            current = pending[current].ParentNode;
+        }
+
+        if (current >= 0 && pending[current].Depth == -2)
+        {
+            AR_CORE_WARN("Transform hierarchy contains a cycle, treating one of its entities as a root");
+            for (uint32 node : chain)
+            {
+                pending[node].Depth = -1;
+            }
+            pending[current].ParentNode = -1;
+            pending[current].Data.ParentWorld = nullptr;
+            pending[current].Data.ParentWorldVersion = nullptr;
+            i--;
+            continue;
+        }
+
+        int32 depth = current >= 0 ? pending[current].Depth : -1;
+        for (auto it = chain.rbegin(); it != chain.rend(); it++)
+        {
+            pending[*it].Depth = ++depth;
+        }
+        if ((uint32)depth + 1 > depth_count)
+        {
+            depth_count = depth + 1;
+        }
+    }
+
+    // Counting sort by depth, keeps chunk order within a level
+    m_LevelOffsets.assign(depth_count + 1, 0);
+    for (const PendingNode& node : pending)
+    {
+        m_LevelOffsets[node.Depth + 1]++;
+    }
+    for (uint32 level = 0; level < depth_count; level++)
+    {
+        m_LevelOffsets[level + 1] += m_LevelOffsets[level];
+    }
+
+    std::vector<uint32> cursors(m_LevelOffsets.begin(), m_LevelOffsets.end() - 1);
+    m_Nodes.resize(pending.size());
+    for (const PendingNode& node : pending)
+    {
+        m_Nodes[cursors[node.Depth]++] = node.Data;
+    }
+}
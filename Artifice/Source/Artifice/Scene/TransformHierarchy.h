@@ -0,0 +1,58 @@
+#pragma once
+
+#include <vector>
+
+#include "Artifice/Core/Core.h"
+#include "Artifice/math/math.h"
+
+#include "Entity.h"
+#include "Component.h"
+
+// Computes the world TransformComponent of entities with a LocalTransformComponent, relative to their ParentComponent.
+// Nodes are kept sorted by hierarchy depth, so an update is a single linear sweep where parents are always computed
+// before their children. Only subtrees whose local transform or parent changed since the last update are recomputed.
+class TransformHierarchy
+{
+private:
+    struct Node
+    {
+        const mat4* Local = nullptr;
+        mat4* World = nullptr;
+        // nullptr for roots
+        const mat4* ParentWorld = nullptr;
+
+        // Chunk column versions of the above
+        const uint32* LocalVersion = nullptr;
+        uint32* WorldVersion = nullptr;
+        const uint32* ParentWorldVersion = nullptr;
+    };
+    struct ArchetypeState
+    {
+        Archetype* Owner;
+        uint32 StructureVersion;
+    };
+
+    EntityRegistry* m_Registry = nullptr;
+    Query<const TransformComponent> m_WorldQuery;
+
+    // Sorted by depth, m_LevelOffsets holds the first node of every level plus the end
+    std::vector<Node> m_Nodes;
+    std::vector<uint32> m_LevelOffsets;
+
+    // Structure of every archetype with a TransformComponent at the last rebuild, node pointers are valid while unchanged
+    std::vector<ArchetypeState> m_Archetypes;
+    uint32 m_LastUpdateVersion = 0;
+
+public:
+    void Init(EntityRegistry* registry);
+    void CleanUp();
+
+    void Update();
+
+    uint32 GetNodeCount() const { return (uint32)m_Nodes.size(); }
+    uint32 GetDepthCount() const { return m_LevelOffsets.empty() ? 0 : (uint32)m_LevelOffsets.size() - 1; }
+
+private:
+    bool IsStale();
+    void Rebuild();
+};
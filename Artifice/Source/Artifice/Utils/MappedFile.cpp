@@ -0,0 +1,93 @@
+#include "MappedFile.h"
+
+#ifdef _WIN32
+    #define WIN32_LEAN_AND_MEAN
+    #include <windows.h>
+#else
+    #include <fcntl.h>
+    #include <sys/mman.h>
+    #include <sys/stat.h>
+    #include <unistd.h>
+#endif
+
+#include "Artifice/Core/Log.h"
+
+bool MappedFile::Open(const std::string& path)
+{
+    Close();
+
+#ifdef _WIN32
+    HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE)
+    {
+        AR_CORE_ERROR("Failed to open file %s", path.c_str());
+        return false;
+    }
+
+    LARGE_INTEGER size;
+    GetFileSizeEx(file, &size);
+
+    HANDLE mapping = size.QuadPart ? CreateFileMappingA(file, nullptr, PAGE_WRITECOPY, 0, 0, nullptr) : nullptr;
+    void* data = mapping ? MapViewOfFile(mapping, FILE_MAP_COPY, 0, 0, 0) : nullptr;
+    if (!data)
+    {
+        AR_CORE_ERROR("Failed to map file %s", path.c_str());
+        if (mapping)
+        {
+            CloseHandle(mapping);
+        }
+        CloseHandle(file);
+        return false;
+    }
+
+    m_File = file;
+    m_Mapping = mapping;
+    m_Data = (uint8*)data;
+    m_Size = size.QuadPart;
+#else
+    int file = open(path.c_str(), O_RDONLY);
+    if (file < 0)
+    {
+        AR_CORE_ERROR("Failed to open file %s", path.c_str());
+        return false;
+    }
+
+    struct stat info;
+    fstat(file, &info);
+
+    void* data = info.st_size ? mmap(nullptr, info.st_size, PROT_READ | PROT_WRITE, MAP_PRIVATE, file, 0) : MAP_FAILED;
+    // The mapping keeps the file referenced
+    close(file);
+    if (data == MAP_FAILED)
+    {
+        AR_CORE_ERROR("Failed to map file %s", path.c_str());
+        return false;
+    }
+
+    m_Data = (uint8*)data;
+    m_Size = info.st_size;
+#endif
+
+    return true;
+}
+
+void MappedFile::Close()
+{
+    if (!m_Data)
+    {
+        return;
+    }
+
+#ifdef _WIN32
+    UnmapViewOfFile(m_Data);
+    CloseHandle((HANDLE)m_Mapping);
+    CloseHandle((HANDLE)m_File);
+#else
+    munmap(m_Data, m_Size);
+#endif
+
+    m_Data = nullptr;
+    m_Size = 0;
+    m_File = nullptr;
+    m_Mapping = nullptr;
+}
@@ -0,0 +1,28 @@
+#pragma once
+
+#include <string>
+
+#include "Artifice/Core/Core.h"
+
+// Read-only file mapped copy-on-write, writes to the mapping stay private to the process
+class MappedFile
+{
+private:
+    uint8* m_Data = nullptr;
+    uint64 m_Size = 0;
+    // Platform file and mapping handles
+    void* m_File = nullptr;
+    void* m_Mapping = nullptr;
+
+public:
+    MappedFile() = default;
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+    ~MappedFile() { Close(); }
+
+    bool Open(const std::string& path);
+    void Close();
+
+    uint8* GetData() const { return m_Data; }
+    uint64 GetSize() const { return m_Size; }
+};
@@ -1,5 +1,10 @@
 #include "AABB.h"
 
+#include <algorithm>
+#include <cmath>
+
+#include "mat4.h"
+
 
 AABB::AABB()
 : Min(vec3()), Max(vec3())
@@ -35,3 +40,85 @@ vec3 AABB::GetCenter() const
 {
     return (Max + Min) * 0.5;
 }
+
+float AABB::GetSurfaceArea() const
+{
+    vec3 size = Max - Min;
+    return 2.0f * (size.x * size.y + size.y * size.z + size.z * size.x);
+}
+
+bool AABB::Contains(const AABB& other) const
+{
+    return Min.x <= other.Min.x && Min.y <= other.Min.y && Min.z <= other.Min.z &&
+           Max.x >= other.Max.x && Max.y >= other.Max.y && Max.z >= other.Max.z;
+}
+
+bool AABB::Overlaps(const AABB& other) const
+{
+    return Min.x <= other.Max.x && Max.x >= other.Min.x &&
+           Min.y <= other.Max.y && Max.y >= other.Min.y &&
+           Min.z <= other.Max.z && Max.z >= other.Min.z;
+}
+
+bool AABB::IntersectRay(const vec3& origin, const vec3& inverse_direction, float max_distance, float& distance) const
+{
+    const float* min = &Min.x;
+    const float* max = &Max.x;
+    const float* o = &origin.x;
+    const float* inverse = &inverse_direction.x;
+
+    float t_min = 0.0f;
+    float t_max = max_distance;
+    for (unsigned int i = 0; i < 3; i++)
+    {
+        float t1 = (min[i] - o[i]) * inverse[i];
+        float t2 = (max[i] - o[i]) * inverse[i];
+        // min/max drop the NaN of a ray parallel to and on a slab plane
+        t_min = std::max(t_min, std::min(t1, t2));
+        t_max = std::min(t_max, std::max(t1, t2));
+        if (t_min > t_max)
+        {
+            return false;
+        }
+    }
+
+    distance = t_min;
+    return true;
+}
+
+AABB AABB::Transformed(const mat4& transform) const
+{
+    vec3 center = GetCenter();
+    vec3 extents = (Max - Min) * 0.5f;
+    const float* c = &center.x;
+    const float* e = &extents.x;
+
+    // Transformed center plus the extents projected on every world axis
+    float new_center[3];
+    float new_extents[3];
+    for (unsigned int row = 0; row < 3; row++)
+    {
+        new_center[row] = transform.elements[row + 3 * 4];
+        new_extents[row] = 0.0f;
+        for (unsigned int col = 0; col < 3; col++)
+        {
+            new_center[row] += transform.elements[row + col * 4] * c[col];
+            new_extents[row] += std::fabs(transform.elements[row + col * 4]) * e[col];
+        }
+    }
+
+    vec3 result_center(new_center[0], new_center[1], new_center[2]);
+    vec3 result_extents(new_extents[0], new_extents[1], new_extents[2]);
+    return AABB(result_center - result_extents, result_center + result_extents);
+}
+
+AABB AABB::Expanded(float margin) const
+{
+    return AABB(Min - vec3(margin), Max + vec3(margin));
+}
+
+AABB AABB::Merge(const AABB& a, const AABB& b)
+{
+    return AABB(vec3(std::min(a.Min.x, b.Min.x), std::min(a.Min.y, b.Min.y), std::min(a.Min.z, b.Min.z)),
+                vec3(std::max(a.Max.x, b.Max.x), std::max(a.Max.y, b.Max.y), std::max(a.Max.z, b.Max.z)));
+}
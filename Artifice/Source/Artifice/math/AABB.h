@@ -4,6 +4,7 @@
 
 #include "vec3.h"
 
+struct mat4;
 
 struct AABB
 {
@@ -15,4 +16,16 @@ struct AABB
     AABB(const std::vector<vec3>& positions);
     
     vec3 GetCenter() const;
+    float GetSurfaceArea() const;
+
+    bool Contains(const AABB& other) const;
+    bool Overlaps(const AABB& other) const;
+    // Slab test, distance is where the ray enters the box (0 if the origin is inside)
+    bool IntersectRay(const vec3& origin, const vec3& inverse_direction, float max_distance, float& distance) const;
+
+    // Box enclosing this box transformed by transform
+    AABB Transformed(const mat4& transform) const;
+    AABB Expanded(float margin) const;
+
+    static AABB Merge(const AABB& a, const AABB& b);
 };
@@ -1,41 +1,35 @@
 #include "Frustum.h"
 
+#include <cmath>
+
 
 void Frustum::ExtractPlanes(const mat4& m)
 {
-    planes[LEFT].x   = m.elements[0 + 3 * 4] + m.elements[0 + 0 * 4];
-    planes[LEFT].y   = m.elements[1 + 3 * 4] + m.elements[1 + 0 * 4];
-    planes[LEFT].z   = m.elements[2 + 3 * 4] + m.elements[2 + 0 * 4];
-    planes[LEFT].w   = m.elements[3 + 3 * 4] + m.elements[3 + 0 * 4];
-    
-    planes[RIGHT].x  = m.elements[0 + 3 * 4] - m.elements[0 + 0 * 4];
-    planes[RIGHT].y  = m.elements[1 + 3 * 4] - m.elements[1 + 0 * 4];
-    planes[RIGHT].z  = m.elements[2 + 3 * 4] - m.elements[2 + 0 * 4];
-    planes[RIGHT].w  = m.elements[3 + 3 * 4] - m.elements[3 + 0 * 4];
-    
-    planes[TOP].x    = m.elements[0 + 3 * 4] - m.elements[0 + 1 * 4];
-    planes[TOP].y    = m.elements[1 + 3 * 4] - m.elements[1 + 1 * 4];
-    planes[TOP].z    = m.elements[2 + 3 * 4] - m.elements[2 + 1 * 4];
-    planes[TOP].w    = m.elements[3 + 3 * 4] - m.elements[3 + 1 * 4];
-
-    planes[BOTTOM].x = m.elements[0 + 3 * 4] + m.elements[0 + 1 * 4];
-    planes[BOTTOM].y = m.elements[1 + 3 * 4] + m.elements[1 + 1 * 4];
-    planes[BOTTOM].z = m.elements[2 + 3 * 4] + m.elements[2 + 1 * 4];
-    planes[BOTTOM].w = m.elements[3 + 3 * 4] + m.elements[3 + 1 * 4];
-    
-    planes[NEAR].x   = m.elements[0 + 3 * 4] + m.elements[0 + 2 * 4];
-    planes[NEAR].y   = m.elements[1 + 3 * 4] + m.elements[1 + 2 * 4];
-    planes[NEAR].z   = m.elements[2 + 3 * 4] + m.elements[2 + 2 * 4];
-    planes[NEAR].w   = m.elements[3 + 3 * 4] + m.elements[3 + 2 * 4];
-    
-    planes[FAR].x    = m.elements[0 + 3 * 4] - m.elements[0 + 2 * 4];
-    planes[FAR].y    = m.elements[1 + 3 * 4] - m.elements[1 + 2 * 4];
-    planes[FAR].z    = m.elements[2 + 3 * 4] - m.elements[2 + 2 * 4];
-    planes[FAR].w    = m.elements[3 + 3 * 4] - m.elements[3 + 2 * 4];
-    
+    // Planes are sums of the matrix rows, elements are column major.
+    // Clip space depth is [0, 1], so the near plane is the third row alone.
+    for (unsigned int col = 0; col < 4; col++)
+    {
+        float row0 = m.elements[0 + col * 4];
+        float row1 = m.elements[1 + col * 4];
+        float row2 = m.elements[2 + col * 4];
+        float row3 = m.elements[3 + col * 4];
+
+        (&planes[LEFT].x)[col]   = row3 + row0;
+        (&planes[RIGHT].x)[col]  = row3 - row0;
+        (&planes[TOP].x)[col]    = row3 - row1;
+        (&planes[BOTTOM].x)[col] = row3 + row1;
+        (&planes[NEAR].x)[col]   = row2;
+        (&planes[FAR].x)[col]    = row3 - row2;
+    }
+
+    // Normalized by the normal length, so plane distances are world distances
     for (unsigned int i = 0; i < 6; i++)
     {
-        planes[i].Normalize();
+        float length = sqrtf(planes[i].x * planes[i].x + planes[i].y * planes[i].y + planes[i].z * planes[i].z);
+        planes[i].x /= length;
+        planes[i].y /= length;
+        planes[i].z /= length;
+        planes[i].w /= length;
     }
 }
 
@@ -51,3 +45,20 @@ bool Frustum::IsSphereVisible(const Sphere& sphere)
     
     return true;
 }
+
+bool Frustum::IsBoxVisible(const AABB& box) const
+{
+    for (unsigned int i = 0; i < 6; i++)
+    {
+        // Corner furthest along the plane normal
+        float x = planes[i].x >= 0 ? box.Max.x : box.Min.x;
+        float y = planes[i].y >= 0 ? box.Max.y : box.Min.y;
+        float z = planes[i].z >= 0 ? box.Max.z : box.Min.z;
+        if (planes[i].x * x + planes[i].y * y + planes[i].z * z + planes[i].w < 0)
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
@@ -2,6 +2,7 @@
 
 #include <vector>
 
+#include "AABB.h"
 #include "mat4.h"
 #include "Sphere.h"
 #include "vec4.h"
@@ -24,4 +25,5 @@ struct Frustum
     void ExtractPlanes(const mat4& m);
     
     bool IsSphereVisible(const Sphere& sphere);
+    bool IsBoxVisible(const AABB& box) const;
 };
@@ -3,6 +3,11 @@
 #include <math.h>
 #include <iomanip>
 
+#if defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+    #include <xmmintrin.h>
+    #define AR_MATH_SSE
+#endif
+
 #include "math_functions.h"
 
 
@@ -28,17 +33,43 @@ mat4 mat4::identity() {
 
 mat4& mat4::multiply(const mat4& other)
 {
-    float result[4 * 4];
+    multiply(*this, other, *this);
+    return *this;
+}
+
+void mat4::multiply(const mat4& left, const mat4& right, mat4& result)
+{
+#ifdef AR_MATH_SSE
+    // Column j of the result is the left columns weighted by column j of right
+    __m128 c0 = _mm_loadu_ps(&left.elements[0]);
+    __m128 c1 = _mm_loadu_ps(&left.elements[4]);
+    __m128 c2 = _mm_loadu_ps(&left.elements[8]);
+    __m128 c3 = _mm_loadu_ps(&left.elements[12]);
+
+    __m128 columns[4];
+    for (unsigned int y = 0; y < 4; y++)
+    {
+        const float* r = &right.elements[y * 4];
+        __m128 sum = _mm_mul_ps(c0, _mm_set1_ps(r[0]));
+        sum = _mm_add_ps(sum, _mm_mul_ps(c1, _mm_set1_ps(r[1])));
+        sum = _mm_add_ps(sum, _mm_mul_ps(c2, _mm_set1_ps(r[2])));
+        sum = _mm_add_ps(sum, _mm_mul_ps(c3, _mm_set1_ps(r[3])));
+        columns[y] = sum;
+    }
+    for (unsigned int y = 0; y < 4; y++)
+        _mm_storeu_ps(&result.elements[y * 4], columns[y]);
+#else
+    float temp[4 * 4];
     for (unsigned int y = 0; y < 4; y++)
         for (unsigned int x = 0; x < 4; x++)
         {
             float sum = 0.0f;
             for (unsigned int i = 0; i < 4; i++)
-                sum += elements[x + i * 4] * other.elements[i + y * 4];
-            result[x + y * 4] = sum;
+                sum += left.elements[x + i * 4] * right.elements[i + y * 4];
+            temp[x + y * 4] = sum;
         }
-    memcpy(elements, result, sizeof(float) * 4 * 4);
-    return *this;
+    memcpy(result.elements, temp, sizeof(float) * 4 * 4);
+#endif
 }
 
 vec3 mat4::multiply(const vec3& other) const
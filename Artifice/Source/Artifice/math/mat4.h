@@ -22,6 +22,8 @@ struct mat4
     static mat4 identity();
 
     mat4& multiply(const mat4& other);
+    // result = left * right, result may alias either operand
+    static void multiply(const mat4& left, const mat4& right, mat4& result);
     friend mat4 operator*(mat4 left, const mat4& right);
     mat4& operator*=(const mat4& other);
 
@@ -0,0 +1,197 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <functional>
+#include <random>
+#include <string>
+#include <vector>
+
+#ifdef _MSC_VER
+    #include <intrin.h>
+#else
+    #include <x86intrin.h>
+#endif
+
+// Only the ECS is used, so no window or graphics device is created
+#include "Artifice/Core/Core.h"
+#include "Artifice/Core/Log.h"
+#include "Artifice/Scene/Entity.h"
+
+// Measures EntityRegistry operations at several entity counts and writes the results as CSV.
+// Usage: Benchmark [output.csv] [label], the label is written to every row to tell runs of different revisions apart.
+
+struct PositionComponent
+{
+    float X, Y, Z;
+};
+struct VelocityComponent
+{
+    float X, Y, Z;
+};
+struct HealthComponent
+{
+    float Health;
+};
+
+struct BenchmarkResult
+{
+    std::string Name;
+    uint32 EntityCount;
+    uint64 Cycles;
+    double Milliseconds;
+    // Registry memory after the operation
+    uint64 MemoryBytes;
+};
+
+class ECSBenchmark
+{
+private:
+    std::vector<BenchmarkResult> m_Results;
+    // Keeps reads from being optimized away
+    float m_Sink = 0.0f;
+
+public:
+    void Run(uint32 entity_count)
+    {
+        EntityRegistry* registry = CreateRegistry();
+        std::vector<EntityHandle> entities;
+        entities.reserve(entity_count);
+
+        Measure("create", entity_count, registry, [&]() {
+            for (uint32 i = 0; i < entity_count; i++)
+            {
+                EntityHandle entity = registry->CreateEntity();
+                registry->AddComponent<PositionComponent>(entity, PositionComponent{(float)i, 0.0f, 0.0f});
+                registry->AddComponent<VelocityComponent>(entity, VelocityComponent{1.0f, 0.0f, 0.0f});
+                entities.push_back(entity);
+            }
+        });
+
+        Measure("add_component", entity_count, registry, [&]() {
+            for (EntityHandle entity : entities)
+            {
+                registry->AddComponent<HealthComponent>(entity, HealthComponent{100.0f});
+            }
+        });
+
+        Measure("remove_component", entity_count, registry, [&]() {
+            for (EntityHandle entity : entities)
+            {
+                registry->RemoveComponent<HealthComponent>(entity);
+            }
+        });
+
+        // Fixed seed so runs access the same sequence
+        std::vector<EntityHandle> shuffled = entities;
+        std::shuffle(shuffled.begin(), shuffled.end(), std::mt19937(1234));
+        Measure("get_component_random", entity_count, registry, [&]() {
+            float sum = 0.0f;
+            for (EntityHandle entity : shuffled)
+            {
+                sum += registry->GetComponent<PositionComponent>(entity)->X;
+            }
+            m_Sink += sum;
+        });
+
+        Query<PositionComponent, const VelocityComponent> query(registry);
+        Measure("iterate", entity_count, registry, [&]() {
+            query.Each([](EntityHandle, PositionComponent& position, const VelocityComponent& velocity) {
+                position.X += velocity.X;
+                position.Y += velocity.Y;
+                position.Z += velocity.Z;
+            });
+        });
+
+        Measure("destroy", entity_count, registry, [&]() {
+            for (EntityHandle entity : entities)
+            {
+                registry->DestroyEntity(entity);
+            }
+        });
+
+        delete registry;
+
+        // Bulk creation into a fresh registry
+        registry = CreateRegistry();
+        Measure("create_bulk", entity_count, registry, [&]() {
+            registry->CreateEntities(entity_count, PositionComponent{0.0f, 0.0f, 0.0f}, VelocityComponent{1.0f, 0.0f, 0.0f});
+        });
+        delete registry;
+    }
+
+    bool WriteCSV(const std::string& path, const std::string& label)
+    {
+        FILE* file = fopen(path.c_str(), "w");
+        if (!file)
+        {
+            AR_CORE_ERROR("Failed to open %s for writing", path.c_str());
+            return false;
+        }
+
+        fprintf(file, "label,benchmark,entities,cycles,cycles_per_entity,ms,memory_bytes\n");
+        for (const BenchmarkResult& result : m_Results)
+        {
+            fprintf(file, "%s,%s,%u,%llu,%.2f,%.3f,%llu\n", label.c_str(), result.Name.c_str(), result.EntityCount,
+                    (unsigned long long)result.Cycles, (double)result.Cycles / result.EntityCount, result.Milliseconds,
+                    (unsigned long long)result.MemoryBytes);
+        }
+
+        fclose(file);
+        return true;
+    }
+
+    float GetSink() const { return m_Sink; }
+
+private:
+    EntityRegistry* CreateRegistry()
+    {
+        EntityRegistry* registry = new EntityRegistry();
+        registry->RegisterComponent<PositionComponent>();
+        registry->RegisterComponent<VelocityComponent>();
+        registry->RegisterComponent<HealthComponent>();
+        return registry;
+    }
+
+    void Measure(const char* name, uint32 entity_count, EntityRegistry* registry, const std::function<void()>& func)
+    {
+        auto start_time = std::chrono::high_resolution_clock::now();
+        uint64 start_cycles = __rdtsc();
+
+        func();
+
+        uint64 end_cycles = __rdtsc();
+        auto end_time = std::chrono::high_resolution_clock::now();
+
+        BenchmarkResult result;
+        result.Name = name;
+        result.EntityCount = entity_count;
+        result.Cycles = end_cycles - start_cycles;
+        result.Milliseconds = std::chrono::duration<double, std::milli>(end_time - start_time).count();
+        result.MemoryBytes = registry->GetMemoryUsage();
+        m_Results.push_back(result);
+
+        printf("%-22s %8u entities %14llu cycles %8.2f cycles/entity %10.3f ms %12llu bytes\n", name, entity_count,
+               (unsigned long long)result.Cycles, (double)result.Cycles / entity_count, result.Milliseconds,
+               (unsigned long long)result.MemoryBytes);
+    }
+};
+
+int main(int argc, char** argv)
+{
+    std::string path = argc > 1 ? argv[1] : "ecs_benchmark.csv";
+    std::string label = argc > 2 ? argv[2] : "current";
+
+    ECSBenchmark benchmark;
+    for (uint32 entity_count : {10000u, 100000u, 1000000u})
+    {
+        benchmark.Run(entity_count);
+    }
+
+    if (!benchmark.WriteCSV(path, label))
+    {
+        return 1;
+    }
+    printf("Wrote %s (checksum %f)\n", path.c_str(), benchmark.GetSink());
+
+    return 0;
+}
@@ -0,0 +1,348 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <random>
+#include <string>
+#include <vector>
+
+// The graph is initialized headless, so no window or graphics device is created
+#include "Artifice/Core/Core.h"
+#include "Artifice/Core/Log.h"
+#include "Artifice/Graphics/RenderGraph/RenderGraph.h"
+
+// Builds and compiles synthetic render graphs of several sizes and writes compile times and synchronization counts as CSV.
+// Usage: RenderGraphBenchmark [output.csv] [label], the label is written to every row to tell runs of different revisions apart.
+
+// Hands out fake semaphores and events, and counts the ones alive so leaks show up in the results
+class HeadlessRenderGraphDevice : public RenderGraphDevice
+{
+private:
+    uint64 m_NextHandle = 1;
+    uint32 m_AliveSemaphores = 0;
+    uint32 m_AliveEvents = 0;
+
+public:
+    TextureInfo GetTextureInfo(RenderHandle) override
+    {
+        // Only the backbuffer is imported, the handle is null
+        TextureInfo info;
+        info.Type = TextureType::Texture2D;
+        info.Width = 1920;
+        info.Height = 1080;
+        info.Format = VK_FORMAT_B8G8R8A8_UNORM;
+        return info;
+    }
+    MemoryRequirements GetTextureMemoryRequirements(const TextureInfo& info) override
+    {
+        uint64 size = (uint64)info.Width * info.Height * info.Depth * info.Layers * 4 * info.Samples;
+        return {size, 65536, 1};
+    }
+
+    VkSemaphore RequestSemaphore() override
+    {
+        m_AliveSemaphores++;
+        return reinterpret_cast<VkSemaphore>(m_NextHandle++);
+    }
+    void ReleaseSemaphore(VkSemaphore) override
+    {
+        m_AliveSemaphores--;
+    }
+    VkEvent CreateBarrierEvent() override
+    {
+        m_AliveEvents++;
+        return reinterpret_cast<VkEvent>(m_NextHandle++);
+    }
+    void DestroyBarrierEvent(VkEvent) override
+    {
+        m_AliveEvents--;
+    }
+
+    uint32 GetAliveSemaphores() const { return m_AliveSemaphores; }
+    uint32 GetAliveEvents() const { return m_AliveEvents; }
+};
+
+// Pass of a synthetic graph, generated before building so the generation is not measured
+struct SyntheticPass
+{
+    QueueType Queue;
+    RenderGraphPassType Type;
+    std::vector<uint32> TextureReads;
+    std::vector<uint32> BufferReads;
+    // Created by the pass when equal to the resource count before it, otherwise an earlier resource
+    std::vector<uint32> TextureWrites;
+    std::vector<uint32> BufferWrites;
+    std::vector<uint32> TextureOutputs;
+};
+
+struct SyntheticGraph
+{
+    std::vector<SyntheticPass> Passes;
+    uint32 TextureCount = 0;
+    uint32 BufferCount = 0;
+};
+
+struct RenderGraphBenchmarkResult
+{
+    uint32 PassCount;
+    double BuildMilliseconds;
+    double CompileMilliseconds;
+    double CachedCompileMilliseconds;
+    RenderGraph::Statistics Stats;
+    uint32 EventCount;
+    uint32 LeakedSemaphores;
+    uint32 LeakedEvents;
+};
+
+class RenderGraphBenchmark
+{
+private:
+    std::vector<RenderGraphBenchmarkResult> m_Results;
+    HeadlessRenderGraphDevice m_Device;
+
+public:
+    void Run(uint32 pass_count, uint32 iterations)
+    {
+        // Fixed seed so runs compile the same graphs
+        SyntheticGraph synthetic = Generate(pass_count, 1234);
+
+        RenderGraphBenchmarkResult result = {};
+        result.PassCount = pass_count;
+        result.BuildMilliseconds = 1e30;
+        result.CompileMilliseconds = 1e30;
+        result.CachedCompileMilliseconds = 1e30;
+
+        // Fastest of the iterations, every one compiles a new graph from scratch and then the same structure again
+        for (uint32 i = 0; i < iterations; i++)
+        {
+            RenderGraph graph;
+            graph.InitHeadless(&m_Device);
+
+            double build_ms = Measure([&]() { Build(&graph, synthetic); });
+            double compile_ms = Measure([&]() { graph.Compile(); });
+            RenderGraph::Statistics stats = graph.GetStats();
+            uint32 events = m_Device.GetAliveEvents();
+
+            graph.Reset();
+            Build(&graph, synthetic);
+            double cached_ms = Measure([&]() { graph.Compile(); });
+            AR_CORE_ASSERT(graph.GetStats().CompileCached, "Rebuilt synthetic graph was compiled again");
+
+            graph.CleanUp();
+
+            result.BuildMilliseconds = std::min(result.BuildMilliseconds, build_ms);
+            result.CompileMilliseconds = std::min(result.CompileMilliseconds, compile_ms);
+            result.CachedCompileMilliseconds = std::min(result.CachedCompileMilliseconds, cached_ms);
+            result.Stats = stats;
+            result.EventCount = events;
+            result.LeakedSemaphores = m_Device.GetAliveSemaphores();
+            result.LeakedEvents = m_Device.GetAliveEvents();
+        }
+        m_Results.push_back(result);
+
+        const RenderGraph::Statistics& stats = result.Stats;
+        printf("%5u passes %5u culled %5u textures %5u buffers | build %8.3f ms compile %8.3f ms cached %8.3f ms | "
+               "%6u barriers %6u split %5u semaphores %5u events | %6.1f MB transient %6.1f MB unaliased\n",
+               pass_count, stats.CulledPassCount, stats.TextureCount, stats.BufferCount, result.BuildMilliseconds,
+               result.CompileMilliseconds, result.CachedCompileMilliseconds, stats.BarrierCount, stats.SplitBarrierCount,
+               stats.SemaphoreCount, result.EventCount, stats.TransientMemory / (1024.0 * 1024.0),
+               stats.TransientMemoryUnaliased / (1024.0 * 1024.0));
+        if (result.LeakedSemaphores || result.LeakedEvents)
+        {
+            AR_CORE_ERROR("Render graph leaked %u semaphores and %u events", result.LeakedSemaphores, result.LeakedEvents);
+        }
+    }
+
+    bool WriteCSV(const std::string& path, const std::string& label)
+    {
+        FILE* file = fopen(path.c_str(), "w");
+        if (!file)
+        {
+            AR_CORE_ERROR("Failed to open %s for writing", path.c_str());
+            return false;
+        }
+
+        fprintf(file, "label,passes,culled,textures,buffers,build_ms,compile_ms,cached_compile_ms,barriers,split_barriers,"
+                      "semaphores,events,transient_bytes,unaliased_bytes,leaked_semaphores,leaked_events\n");
+        for (const RenderGraphBenchmarkResult& result : m_Results)
+        {
+            const RenderGraph::Statistics& stats = result.Stats;
+            fprintf(file, "%s,%u,%u,%u,%u,%.3f,%.3f,%.3f,%u,%u,%u,%u,%llu,%llu,%u,%u\n", label.c_str(), result.PassCount,
+                    stats.CulledPassCount, stats.TextureCount, stats.BufferCount, result.BuildMilliseconds,
+                    result.CompileMilliseconds, result.CachedCompileMilliseconds, stats.BarrierCount,
+                    stats.SplitBarrierCount, stats.SemaphoreCount, result.EventCount,
+                    (unsigned long long)stats.TransientMemory, (unsigned long long)stats.TransientMemoryUnaliased,
+                    result.LeakedSemaphores, result.LeakedEvents);
+        }
+
+        fclose(file);
+        return true;
+    }
+
+private:
+    // Most accesses are to recently written resources, like the chains of a real frame, the rest are random so some
+    // barriers span many passes. A quarter of the passes run on the compute queue.
+    static SyntheticGraph Generate(uint32 pass_count, uint32 seed)
+    {
+        std::mt19937 random(seed);
+        auto chance = [&random](float probability) {
+            return std::uniform_real_distribution<float>(0.0f, 1.0f)(random) < probability;
+        };
+        auto pick = [&random, &chance](uint32 count) {
+            uint32 window = chance(0.8f) ? std::min(count, 16u) : count;
+            return count - 1 - std::uniform_int_distribution<uint32>(0, window - 1)(random);
+        };
+        auto add_unique = [](std::vector<uint32>& indices, uint32 index) {
+            if (std::find(indices.begin(), indices.end(), index) == indices.end())
+            {
+                indices.push_back(index);
+            }
+        };
+
+        SyntheticGraph graph;
+        for (uint32 i = 0; i < pass_count; i++)
+        {
+            SyntheticPass pass;
+            pass.Queue = chance(0.25f) ? QueueType::Compute : QueueType::Universal;
+            pass.Type = pass.Queue == QueueType::Universal && chance(0.6f) ? RenderGraphPassType::Render : RenderGraphPassType::Other;
+
+            uint32 read_count = std::uniform_int_distribution<uint32>(0, 3)(random);
+            for (uint32 r = 0; r < read_count && graph.TextureCount; r++)
+            {
+                add_unique(pass.TextureReads, pick(graph.TextureCount));
+            }
+            if (graph.BufferCount && chance(0.3f))
+            {
+                add_unique(pass.BufferReads, pick(graph.BufferCount));
+            }
+
+            // Render passes write one or two color targets, other passes storage textures or buffers
+            uint32 write_count = std::uniform_int_distribution<uint32>(1, 2)(random);
+            for (uint32 w = 0; w < write_count; w++)
+            {
+                bool buffer = pass.Type == RenderGraphPassType::Other && chance(0.3f);
+                uint32& count = buffer ? graph.BufferCount : graph.TextureCount;
+                std::vector<uint32>& writes = buffer ? pass.BufferWrites : pass.TextureWrites;
+                std::vector<uint32>& reads = buffer ? pass.BufferReads : pass.TextureReads;
+
+                uint32 index = count == 0 || chance(0.5f) ? count++ : pick(count);
+                if (std::find(reads.begin(), reads.end(), index) == reads.end())
+                {
+                    add_unique(writes, index);
+                }
+            }
+
+            // Some results are used outside the graph, the rest is culled when nothing reads it
+            if (pass.TextureWrites.size() && chance(0.05f))
+            {
+                pass.TextureOutputs.push_back(pass.TextureWrites[0]);
+            }
+
+            graph.Passes.push_back(pass);
+        }
+
+        return graph;
+    }
+
+    static void Build(RenderGraph* graph, const SyntheticGraph& synthetic)
+    {
+        // Created by the first pass that writes them, so the handles are only known while building
+        std::vector<RenderGraphTextureHandle> textures(synthetic.TextureCount);
+        std::vector<RenderGraphBufferHandle> buffers(synthetic.BufferCount);
+        uint32 texture_count = 0;
+        uint32 buffer_count = 0;
+
+        for (uint32 i = 0; i < synthetic.Passes.size(); i++)
+        {
+            const SyntheticPass& pass = synthetic.Passes[i];
+            graph->AddPass("Pass " + std::to_string(i), [&](RenderGraphBuilder* builder) {
+                builder->SetQueue(pass.Queue);
+                builder->SetType(pass.Type);
+
+                bool render = pass.Type == RenderGraphPassType::Render;
+                ResourceState read_state = render ? ResourceState::SampledFragment() : ResourceState::SampledCompute();
+                ResourceState texture_write_state = render ? ResourceState::Color() : ResourceState::StorageTextureCompute();
+                ResourceState buffer_read_state = {RenderBindFlags::StorageBuffer, render ? PipelineStageFlags::Fragment : PipelineStageFlags::Compute};
+                ResourceState buffer_write_state = {RenderBindFlags::StorageBuffer, PipelineStageFlags::Compute};
+
+                for (uint32 index : pass.TextureReads)
+                {
+                    builder->ReadTexture(textures[index], read_state);
+                }
+                for (uint32 index : pass.BufferReads)
+                {
+                    builder->ReadBuffer(buffers[index], buffer_read_state);
+                }
+                for (uint32 index : pass.TextureWrites)
+                {
+                    if (index == texture_count)
+                    {
+                        TextureInfo info;
+                        info.Type = TextureType::Texture2D;
+                        info.Width = index % 3 ? 1920 : 960;
+                        info.Height = index % 3 ? 1080 : 540;
+                        info.Format = VK_FORMAT_R16G16B16A16_SFLOAT;
+                        textures[index] = builder->CreateTexture("Texture " + std::to_string(index), info);
+                        texture_count++;
+                    }
+                    builder->WriteTexture(textures[index], texture_write_state);
+                }
+                for (uint32 index : pass.BufferWrites)
+                {
+                    if (index == buffer_count)
+                    {
+                        BufferInfo info = {RenderBindFlags::None, MemoryAccessType::Gpu, 1 << 20};
+                        buffers[index] = builder->CreateBuffer("Buffer " + std::to_string(index), info);
+                        buffer_count++;
+                    }
+                    builder->WriteBuffer(buffers[index], buffer_write_state);
+                }
+                for (uint32 index : pass.TextureOutputs)
+                {
+                    builder->MarkTextureOutput(textures[index]);
+                }
+
+                return [](RenderGraphRegistry*, CommandBuffer*) {};
+            });
+        }
+
+        // Composites the latest textures, like the final passes of a frame
+        graph->AddPass("Composite", [&](RenderGraphBuilder* builder) {
+            for (uint32 i = texture_count > 4 ? texture_count - 4 : 0; i < texture_count; i++)
+            {
+                builder->ReadTexture(textures[i], ResourceState::SampledFragment());
+            }
+            RenderGraphTextureHandle backbuffer = builder->ImportTexture("Backbuffer", RenderHandle());
+            builder->WriteTexture(backbuffer, ResourceState::Color(), true);
+            return [](RenderGraphRegistry*, CommandBuffer*) {};
+        });
+    }
+
+    template <class F>
+    static double Measure(F&& func)
+    {
+        auto start_time = std::chrono::high_resolution_clock::now();
+        func();
+        auto end_time = std::chrono::high_resolution_clock::now();
+        return std::chrono::duration<double, std::milli>(end_time - start_time).count();
+    }
+};
+
+int main(int argc, char** argv)
+{
+    std::string path = argc > 1 ? argv[1] : "render_graph_benchmark.csv";
+    std::string label = argc > 2 ? argv[2] : "current";
+
+    RenderGraphBenchmark benchmark;
+    for (uint32 pass_count : {100u, 250u, 500u, 1000u, 2500u, 5000u})
+    {
+        benchmark.Run(pass_count, 5);
+    }
+
+    if (!benchmark.WriteCSV(path, label))
+    {
+        return 1;
+    }
+    printf("Wrote %s\n", path.c_str());
+
+    return 0;
+}
@@ -120,12 +120,19 @@ void Atmosphere::Init(AtmosphereParameters params, uint32 order)
     m_MultipleScatteringShaderSystem.SetStorageTexture(4, m_ScatteringReadTexture);
     m_MultipleScatteringShaderSystem.SetStorageTexture(5, m_ScatteringTexture);
 
+    m_Precompute.Init(device, [this](RenderGraph* graph) { ConstructPrecompute(graph); });
+    m_Precompute.AddOutput("Transmittance", m_TransmittanceTexture, ResourceState::SampledCompute(), QueueType::Compute);
+    m_Precompute.AddOutput("Irradiance", m_IrradianceTexture, ResourceState::SampledCompute(), QueueType::Compute);
+    m_Precompute.AddOutput("Scattering", m_ScatteringTexture, ResourceState::SampledCompute(), QueueType::Compute);
+
     Update(m_Params, m_ScatteringOrder);
 }
 void Atmosphere::Shutdown()
 {
     Device* device = Application::Get()->GetRenderBackend()->GetDevice();
 
+    m_Precompute.CleanUp();
+
     device->DestroyTexture(m_TransmittanceTexture);
     device->DestroyTexture(m_DeltaIrradianceTexture);
     device->DestroyTexture(m_DeltaRayleighTexture);
@@ -157,6 +164,13 @@ void Atmosphere::Shutdown()
 
 void Atmosphere::Update(AtmosphereParameters params, uint32 order)
 {
+    // The order decides the number of passes
+    if (order != m_ScatteringOrder)
+    {
+        m_Precompute.Invalidate();
+    }
+    m_Precompute.MarkDirty();
+
     m_Params = params;
     m_ScatteringOrder = order;
 
@@ -167,19 +181,21 @@ void Atmosphere::Update(AtmosphereParameters params, uint32 order)
     m_ScatteringDensityShaderSystem.SetUniformBuffer<AtmosphereParameters>(0, m_Params);
     m_IndirectIrradianceShaderSystem.SetUniformBuffer<AtmosphereParameters>(0, m_Params);
     m_MultipleScatteringShaderSystem.SetUniformBuffer<AtmosphereParameters>(0, m_Params);
-
-    Precompute();
 }
 
-void Atmosphere::Precompute()
+void Atmosphere::ImportTextures(RenderGraphBuilder* builder)
 {
-    RenderGraph graph(Application::Get()->GetRenderBackend()->GetDevice());
+    m_Precompute.Import(builder, "Transmittance");
+    m_Precompute.Import(builder, "Irradiance");
+    m_Precompute.Import(builder, "Scattering");
+}
 
-    graph.AddPass("Transmittance", [&](RenderGraphBuilder* builder) {
+void Atmosphere::ConstructPrecompute(RenderGraph* graph)
+{
+    graph->AddPass("Transmittance", [&](RenderGraphBuilder* builder) {
         builder->SetQueue(QueueType::Universal);
         builder->SetType(RenderGraphPassType::Other);
 
-        builder->ImportTexture("Transmittance", m_TransmittanceTexture);
         builder->WriteTexture("Transmittance", ResourceState::StorageTextureCompute());
 
         return [=](RenderGraphRegistry* registry, CommandBuffer* cmd) {
@@ -190,7 +206,7 @@ void Atmosphere::Precompute()
             cmd->Dispatch(info.Width / WORKGROUP_SIZE_2D, info.Height / WORKGROUP_SIZE_2D, 1);
         };
     });
-    graph.AddPass("DirectIrradiance", [&](RenderGraphBuilder* builder) {
+    graph->AddPass("DirectIrradiance", [&](RenderGraphBuilder* builder) {
         builder->SetQueue(QueueType::Universal);
         builder->SetType(RenderGraphPassType::Other);
 
@@ -207,13 +223,12 @@ void Atmosphere::Precompute()
             cmd->Dispatch(info.Width / WORKGROUP_SIZE_2D, info.Height / WORKGROUP_SIZE_2D, 1);
         };
     });
-    graph.AddPass("SingleScattering", [&](RenderGraphBuilder* builder) {
+    graph->AddPass("SingleScattering", [&](RenderGraphBuilder* builder) {
         builder->SetQueue(QueueType::Universal);
         builder->SetType(RenderGraphPassType::Other);
 
         builder->ImportTexture("DeltaRayleigh", m_DeltaRayleighTexture);
         builder->ImportTexture("DeltaMie", m_DeltaMieTexture);
-        builder->ImportTexture("Scattering", m_ScatteringTexture);
 
         builder->ReadTexture("Transmittance", ResourceState::SampledCompute());
         builder->WriteTexture("DeltaRayleigh", ResourceState::StorageTextureCompute());
@@ -229,13 +244,12 @@ void Atmosphere::Precompute()
         };
     });
     // Empty render graph render pass to
-    // 1. import Irradiance, DeltaMultipleScattering and ScatteringDensity textures
+    // 1. import IrradianceRead, ScatteringRead, DeltaMultipleScattering and ScatteringDensity textures
     // 2. clear DeltaMultipleScattering
-    graph.AddPass("Transition for Multiple Scattering", [&](RenderGraphBuilder* builder) {
+    graph->AddPass("Transition for Multiple Scattering", [&](RenderGraphBuilder* builder) {
         builder->SetQueue(QueueType::Universal);
         builder->SetType(RenderGraphPassType::Render);
 
-        builder->ImportTexture("Irradiance", m_IrradianceTexture);
         builder->ImportTexture("IrradianceRead", m_IrradianceReadTexture);
         builder->ImportTexture("ScatteringRead", m_ScatteringReadTexture);
         builder->ImportTexture("DeltaMultipleScattering", m_DeltaMultipleScatteringTexture);
@@ -251,7 +265,7 @@ void Atmosphere::Precompute()
     // Calculate higher scattering orders
     for (int32 i = 2; i < m_ScatteringOrder; i++)
     {
-        graph.AddPass("ScatteringDensity " + std::to_string(i), [&](RenderGraphBuilder* builder) {
+        graph->AddPass("ScatteringDensity " + std::to_string(i), [&](RenderGraphBuilder* builder) {
             builder->SetQueue(QueueType::Universal);
             builder->SetType(RenderGraphPassType::Other);
 
@@ -271,7 +285,7 @@ void Atmosphere::Precompute()
                 cmd->Dispatch(info.Width / WORKGROUP_SIZE_3D, info.Height / WORKGROUP_SIZE_3D, info.Depth / WORKGROUP_SIZE_3D);
             };
         });
-        graph.AddPass("Copy Irradiance and Scattering " + std::to_string(i), [&](RenderGraphBuilder* builder) {
+        graph->AddPass("Copy Irradiance and Scattering " + std::to_string(i), [&](RenderGraphBuilder* builder) {
             builder->SetQueue(QueueType::Universal);
             builder->SetType(RenderGraphPassType::Other);
 
@@ -285,7 +299,7 @@ void Atmosphere::Precompute()
                 cmd->CopyTexture(registry->GetTexture("Scattering"), registry->GetTexture("ScatteringRead"));
             };
         });
-        graph.AddPass("IndirectIrradiance " + std::to_string(i), [&](RenderGraphBuilder* builder) {
+        graph->AddPass("IndirectIrradiance " + std::to_string(i), [&](RenderGraphBuilder* builder) {
             builder->SetQueue(QueueType::Universal);
             builder->SetType(RenderGraphPassType::Other);
 
@@ -305,7 +319,7 @@ void Atmosphere::Precompute()
                 cmd->Dispatch(info.Width / WORKGROUP_SIZE_2D, info.Height / WORKGROUP_SIZE_2D, 1);
             };
         });
-        graph.AddPass("MultipleScattering " + std::to_string(i), [&](RenderGraphBuilder* builder) {
+        graph->AddPass("MultipleScattering " + std::to_string(i), [&](RenderGraphBuilder* builder) {
             builder->SetQueue(QueueType::Universal);
             builder->SetType(RenderGraphPassType::Other);
 
@@ -324,27 +338,6 @@ void Atmosphere::Precompute()
             };
         });
     }
-
-    graph.AddPass("Transition for Rendering", [&](RenderGraphBuilder* builder) {
-        builder->SetQueue(QueueType::Universal);
-        builder->SetType(RenderGraphPassType::Other);
-
-        builder->ReadTexture("Transmittance", ResourceState::SampledFragment());
-        builder->ReadTexture("Irradiance", ResourceState::SampledFragment());
-        builder->ReadTexture("Scattering", ResourceState::SampledFragment());
-
-        return [=](RenderGraphRegistry* registry, CommandBuffer* cmd) {
-
-        };
-    });
-    graph.Compile();
-    graph.Evaluate();
-
-    m_PrecomputeStats = graph.GetStats();
-
-    graph.CleanUp();
-
-    m_NeedsPrecompute = false;
 }
 
 void Atmosphere::LoadShaders()
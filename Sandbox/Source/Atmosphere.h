@@ -111,8 +111,8 @@ private:
     AtmosphereParameters m_Params;
     uint32 m_ScatteringOrder = 4;
 
-    RenderGraph::Statistics m_PrecomputeStats;
-    bool m_NeedsPrecompute = true;
+    // Only evaluated again when the parameters change
+    RenderGraphSubgraph m_Precompute;
 
 private:
     ShaderLibrary m_ShaderLibrary;
@@ -158,13 +158,17 @@ public:
 
     AtmosphereParameters GetParameters() const { return m_Params; }
     // Retrieve textures for use in rendering
-    // All guaranteed to be in ResourceState::SampledFragment()
+    // Only valid in passes on QueueType::Compute that called ImportTextures, in ResourceState::SampledCompute()
     AtmosphereTextures GetTextures() const
     {
         return {m_TransmittanceTexture, m_ScatteringTexture, m_IrradianceTexture, m_Sampler};
     }
+    // Reads the textures in the pass, precomputing them first when the parameters changed
+    void ImportTextures(RenderGraphBuilder* builder);
+
+    RenderGraph::Statistics GetPrecomputeStats() const { return m_Precompute.GetStats(); }
 
 private:
-    void Precompute();
+    void ConstructPrecompute(RenderGraph* graph);
     void LoadShaders();
 };
\ No newline at end of file
@@ -605,6 +605,8 @@ void Sandbox3D::OnImGuiRender()
         ImGui::Text("Render Passes: %d", stats.RenderPassCount);
         ImGui::Text("Textures: %d", stats.TextureCount);
         ImGui::Text("Buffers: %d", stats.BufferCount);
+        ImGui::Text("Barriers: %d (%d split)", stats.BarrierCount, stats.SplitBarrierCount);
+        ImGui::Text("Semaphores: %d", stats.SemaphoreCount);
         ImGui::Text("Alive Framebuffers: %d", stats.AliveFramebufferCount);
         ImGui::Text("Alive Render Passes: %d", stats.RenderPassCount);
         ImGui::Text("Alive Textures: %d", stats.AliveTextureCount);
@@ -941,11 +943,15 @@ void OldEnvironmentGen()
     // Copy base mip of environment map to prefilter map
     cmd = device->RequestCommandBuffer();
     cmd.Begin();
-    cmd.TextureBarrier(m_CubemapTexture, ResourceState::SampledCompute(), ResourceState::TransferSource());
-    cmd.TextureBarrier(m_PrefilterTexture, ResourceState::None(), ResourceState::TransferDestination());
+    BarrierBatch copy_barriers;
+    cmd.AddTextureBarrier(&copy_barriers, m_CubemapTexture, ResourceState::SampledCompute(), ResourceState::TransferSource());
+    cmd.AddTextureBarrier(&copy_barriers, m_PrefilterTexture, ResourceState::None(), ResourceState::TransferDestination());
+    cmd.PipelineBarrier(copy_barriers);
     cmd.CopyTexture(m_CubemapTexture, m_PrefilterTexture);
-    cmd.TextureBarrier(m_CubemapTexture, ResourceState::TransferSource(), ResourceState::SampledCompute());
-    cmd.TextureBarrier(m_PrefilterTexture, ResourceState::TransferDestination(), ResourceState::StorageTextureCompute());
+    BarrierBatch prefilter_barriers;
+    cmd.AddTextureBarrier(&prefilter_barriers, m_CubemapTexture, ResourceState::TransferSource(), ResourceState::SampledCompute());
+    cmd.AddTextureBarrier(&prefilter_barriers, m_PrefilterTexture, ResourceState::TransferDestination(), ResourceState::StorageTextureCompute());
+    cmd.PipelineBarrier(prefilter_barriers);
     cmd.End();
     device->CommitCommandBuffer(cmd);
 
@@ -984,8 +990,10 @@ void OldEnvironmentGen()
 
         device->DestroyDescriptorSet(prefilter_ds1);
     }
-    cmd.TextureBarrier(m_CubemapTexture, ResourceState::SampledCompute(), ResourceState::SampledFragment());
-    cmd.TextureBarrier(m_PrefilterTexture, ResourceState::StorageTextureCompute(), ResourceState::SampledFragment());
+    BarrierBatch sample_barriers;
+    cmd.AddTextureBarrier(&sample_barriers, m_CubemapTexture, ResourceState::SampledCompute(), ResourceState::SampledFragment());
+    cmd.AddTextureBarrier(&sample_barriers, m_PrefilterTexture, ResourceState::StorageTextureCompute(), ResourceState::SampledFragment());
+    cmd.PipelineBarrier(sample_barriers);
     cmd.End();
     device->CommitCommandBuffer(cmd);
     device->SubmitQueue(QueueType::Universal);
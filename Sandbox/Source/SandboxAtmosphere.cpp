@@ -204,14 +204,14 @@ void SandboxAtmosphere::OnConstructRenderGraph(RenderGraph* graph)
 
         builder->CreateTexture("PBR Scene MS Color", color);
         //builder->CreateTexture("PBR Scene MS Depth", depth);
-        builder->CreateTexture("PBR Scene Depth", depth);
-        builder->CreateTexture("PBR Scene Color", resolve);
+        RenderGraphTextureHandle scene_depth = builder->CreateTexture("PBR Scene Depth", depth);
+        RenderGraphTextureHandle scene_color = builder->CreateTexture("PBR Scene Color", resolve);
 
         //builder->WriteTexture("PBR Scene MS Color", ResourceState::Color(), true);
         //builder->WriteTexture("PBR Scene MS Depth", ResourceState::Depth(), true);
         //builder->WriteTexture("PBR Scene Color", ResourceState::Resolve());
-        builder->WriteTexture("PBR Scene Color", ResourceState::Color());
-        builder->WriteTexture("PBR Scene Depth", ResourceState::Depth(), true);
+        builder->WriteTexture(scene_color, ResourceState::Color());
+        builder->WriteTexture(scene_depth, ResourceState::Depth(), true);
 
         RenderPassLayout rpl = builder->GetRenderPassInfo().Layout;
 
@@ -226,10 +226,12 @@ void SandboxAtmosphere::OnConstructRenderGraph(RenderGraph* graph)
         };
     });
     graph->AddPass("PBR Composite", [&](RenderGraphBuilder* builder) {
-        builder->ReadTexture("PBR Scene Color", ResourceState::SampledFragment());
-        builder->ReadWriteTexture(RENDER_GRAPH_PRIMARY_SWAPCHAIN_NAME, ResourceState::Color());
+        RenderGraphTextureHandle scene_color = builder->GetTextureHandle("PBR Scene Color");
+        RenderGraphTextureHandle swapchain = builder->GetTextureHandle(RENDER_GRAPH_PRIMARY_SWAPCHAIN_NAME);
+        builder->ReadTexture(scene_color, ResourceState::SampledFragment());
+        builder->ReadWriteTexture(swapchain, ResourceState::Color());
 
-        TextureInfo color = builder->GetTextureInfo(RENDER_GRAPH_PRIMARY_SWAPCHAIN_NAME);
+        TextureInfo color = builder->GetTextureInfo(swapchain);
         RenderPassLayout rpl = builder->GetRenderPassInfo().Layout;
 
         return [=](RenderGraphRegistry* registry, CommandBuffer* cmd) {
@@ -237,7 +239,7 @@ void SandboxAtmosphere::OnConstructRenderGraph(RenderGraph* graph)
             cmd->SetScissor(0, 0, color.Width, color.Height);
 
             SceneRenderer::SetExposure(m_Exposure);
-            SceneRenderer::DrawComposite(registry->GetTexture("PBR Scene Color"), rpl, cmd);
+            SceneRenderer::DrawComposite(registry->GetTexture(scene_color), rpl, cmd);
         };
     });
 #if 0
@@ -291,6 +293,7 @@ void SandboxAtmosphere::RenderToCubemap(RenderGraph* graph, RenderHandle texture
 
         builder->ImportTexture("Cubemap", texture);
         builder->WriteTexture("Cubemap", ResourceState::StorageTextureCompute());
+        m_Atmosphere.ImportTextures(builder);
         
         TextureInfo info = builder->GetTextureInfo("Cubemap");
 
@@ -316,6 +319,7 @@ void SandboxAtmosphere::RenderToCubemap(RenderGraph* graph, RenderHandle texture
 
         builder->ImportTexture("Skybox", m_Skybox);
         builder->WriteTexture("Skybox", ResourceState::StorageTextureCompute());
+        m_Atmosphere.ImportTextures(builder);
 
         TextureInfo info = builder->GetTextureInfo("Skybox");
 
@@ -435,6 +439,7 @@ void SandboxAtmosphere::OnUpdate(Timestep ts)
     }
 
     m_CameraController.OnUpdate(ts);
+    m_Scene.OnUpdate(ts);
 }
 
 void SandboxAtmosphere::OnImGuiRender()
@@ -454,6 +459,7 @@ void SandboxAtmosphere::OnImGuiRender()
         RenderGraph::Statistics stats = Application::Get()->GetRenderGraph()->GetStats();
         ImGui::Text("Render Graph Stats:");
         ImGui::Text("Total Passes: %d", stats.TotalPassCount);
+        ImGui::Text("Culled Passes: %d", stats.CulledPassCount);
         ImGui::Text("Render Passes: %d", stats.RenderPassCount);
         ImGui::Text("Textures: %d", stats.TextureCount);
         ImGui::Text("Buffers: %d", stats.BufferCount);
@@ -461,6 +467,7 @@ void SandboxAtmosphere::OnImGuiRender()
         ImGui::Text("Alive Render Passes: %d", stats.RenderPassCount);
         ImGui::Text("Alive Textures: %d", stats.AliveTextureCount);
         ImGui::Text("Alive Buffers: %d", stats.AliveTextureCount);
+        ImGui::Text("Transient memory: %.2f MiB (%.2f MiB unaliased)", stats.TransientMemory / (1024.0f * 1024.0f), stats.TransientMemoryUnaliased / (1024.0f * 1024.0f));
         ImGui::Text("Construction time: %f", stats.ConstructionTime);
         ImGui::Text("Evaluation time: %f", stats.EvaluationTime);
         for (uint32 i = 0; i < stats.PassNames.size(); i++)
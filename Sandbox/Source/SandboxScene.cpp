@@ -130,10 +130,11 @@ void SandboxScene::OnUpdate(Timestep ts)
     AR_PROFILE_FUNCTION();
 
     m_FPSCameraController.OnUpdate(ts);
-    m_Scene.GetRegistry()->Advance();
 
     mesh1->OnUpdate(ts);
     mesh2->OnUpdate(ts);
+
+    m_Scene.OnUpdate(ts);
 }
 
 void SandboxScene::OnImGuiRender()
@@ -539,3 +539,127 @@ project "Sandbox"
 		defines "AR_RELEASE"
 		runtime "Release"
 		optimize "On"
+
+
+-- Standalone ECS benchmarks, only uses the ECS so no window or graphics device is needed
+project "Benchmark"
+    location "Benchmark"
+    kind "ConsoleApp"
+    language "C++"
+    cppdialect "C++17"
+	staticruntime "On"
+
+	targetdir ("bin/" .. outputdir .. "/%{prj.name}")
+	objdir ("bin-int/" .. outputdir .. "/%{prj.name}")
+
+	files
+	{
+		"%{prj.name}/Source/**.h",
+		"%{prj.name}/Source/**.cpp"
+	}
+	removefiles
+	{
+		"%{prj.name}/Source/RenderGraphBenchmark.cpp"
+	}
+
+	sysincludedirs
+	{
+        "Artifice/Source",
+    }
+    links
+    {
+        "Artifice"
+    }
+
+    filter "system:windows"
+        debugdir "$(OutDir)"
+        systemversion "latest"
+
+        defines
+        {
+            "AR_PLATFORM_WINDOWS"
+        }
+
+	filter "system:macosx"
+		defines
+		{
+            "AR_PLATFORM_MAC"
+        }
+
+	filter "configurations:Debug"
+		defines "AR_DEBUG"
+		runtime "Debug"
+		symbols "On"
+
+	filter "configurations:Release"
+		defines "AR_RELEASE"
+		runtime "Release"
+		optimize "On"
+
+
+-- Render graph compile benchmarks on synthetic graphs, the graph runs headless so no GPU is needed.
+-- Still links Vulkan, the evaluation code of the graph is part of the same library.
+project "RenderGraphBenchmark"
+    location "Benchmark"
+    kind "ConsoleApp"
+    language "C++"
+    cppdialect "C++17"
+	staticruntime "On"
+
+	targetdir ("bin/" .. outputdir .. "/%{prj.name}")
+	objdir ("bin-int/" .. outputdir .. "/%{prj.name}")
+
+	files
+	{
+		"Benchmark/Source/RenderGraphBenchmark.cpp"
+	}
+
+	sysincludedirs
+	{
+        "Artifice/Source",
+        "%{IncludeDir.GLFW}",
+        "%{IncludeDir.ImGui}",
+        "%{IncludeDir.Vulkan}",
+    }
+    links
+    {
+        "Artifice"
+    }
+
+    filter "system:windows"
+        debugdir "$(OutDir)"
+        systemversion "latest"
+        links { "vulkan-1" }
+        libdirs { "C:/VulkanSDK/1.1.130.0/Lib" }
+
+        defines
+        {
+            "AR_PLATFORM_WINDOWS"
+        }
+
+	filter "system:macosx"
+        libdirs
+        {
+            "%{MacDir.VulkanSDK}/lib",
+        }
+        links
+        {
+            "vulkan.1",
+            "Cocoa.framework",
+            "IOKit.framework",
+            "QuartzCore.framework",
+        }
+		defines
+		{
+            "AR_PLATFORM_MAC"
+        }
+
+	filter "configurations:Debug"
+		defines "AR_DEBUG"
+		runtime "Debug"
+		symbols "On"
+
+	filter "configurations:Release"
+		defines "AR_RELEASE"
+		runtime "Release"
+		optimize "On"